@@ -0,0 +1,230 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "AsyncShaderHasher.h"
+
+#define ASYNC_HASHING_WORKER_COUNT 2
+
+namespace ShaderToggler
+{
+	AsyncShaderHasher::AsyncShaderHasher(ShaderHashCache& hashCache): _hashCache(hashCache)
+	{
+	}
+
+
+	bool AsyncShaderHasher::addPipeline(const void* device, uint64_t pipelineHandle, std::vector<PendingShader>& shaders)
+	{
+		const PipelineKey key = { device, pipelineHandle };
+		{
+			// the pipeline becomes pending under the work queue lock, so it's either rejected here or its work is queued before a stop discards it.
+			std::unique_lock lock(_workQueueMutex);
+			if(_isStopped)
+			{
+				return false;
+			}
+			uint64_t ticket = 0;
+			{
+				std::unique_lock pendingLock(_pendingPipelinesMutex);
+				ticket = ++_lastTicket;
+				_pendingTicketPerPipeline[key] = ticket;
+				_pendingPipelineCount = _pendingTicketPerPipeline.size();
+			}
+			startWorkersIfRequired();
+			_workQueue.push_back({ key, ticket, std::move(shaders) });
+		}
+		_workAvailable.notify_one();
+		return true;
+	}
+
+
+	void AsyncShaderHasher::cancelPipeline(const void* device, uint64_t pipelineHandle)
+	{
+		if(_pendingPipelineCount <= 0)
+		{
+			return;
+		}
+		std::unique_lock lock(_pendingPipelinesMutex);
+		_pendingTicketPerPipeline.erase({ device, pipelineHandle });
+		_pendingPipelineCount = _pendingTicketPerPipeline.size();
+	}
+
+
+	void AsyncShaderHasher::cancelDevice(const void* device)
+	{
+		{
+			std::unique_lock lock(_workQueueMutex);
+			std::erase_if(_workQueue, [device](const PipelineWork& work) { return work.key.device == device; });
+		}
+		// a worker only uses the shader managers while it holds this lock and the ticket of its work is still pending, so once the tickets are
+		// gone, work of the device which is being hashed right now is discarded when it completes.
+		std::unique_lock lock(_pendingPipelinesMutex);
+		std::erase_if(_pendingTicketPerPipeline, [device](const auto& pendingTicket) { return pendingTicket.first.device == device; });
+		_pendingPipelineCount = _pendingTicketPerPipeline.size();
+	}
+
+
+	bool AsyncShaderHasher::isPendingPipeline(const void* device, uint64_t pipelineHandle)
+	{
+		if(_pendingPipelineCount <= 0)
+		{
+			return false;
+		}
+		std::unique_lock lock(_pendingPipelinesMutex);
+		return _pendingTicketPerPipeline.count({ device, pipelineHandle }) == 1;
+	}
+
+
+	uint32_t AsyncShaderHasher::stopWorkers()
+	{
+		std::vector<std::thread> workers;
+		std::deque<PipelineWork> discardedWork;
+		{
+			std::unique_lock lock(_workQueueMutex);
+			_stopRequested = true;
+			discardedWork.swap(_workQueue);
+			workers.swap(_workers);
+		}
+		_workAvailable.notify_all();
+		for(auto& worker : workers)
+		{
+			worker.join();
+		}
+		uint32_t discardedPipelineCount = 0;
+		{
+			// only the discarded work won't complete its pipelines. Work queued meanwhile keeps its pipelines pending.
+			std::unique_lock lock(_pendingPipelinesMutex);
+			for(const auto& work : discardedWork)
+			{
+				const auto it = _pendingTicketPerPipeline.find(work.key);
+				if(it != _pendingTicketPerPipeline.end() && it->second == work.ticket)
+				{
+					_pendingTicketPerPipeline.erase(it);
+					++discardedPipelineCount;
+				}
+			}
+			_pendingPipelineCount = _pendingTicketPerPipeline.size();
+		}
+		bool isWorkQueued = false;
+		{
+			std::unique_lock lock(_workQueueMutex);
+			_stopRequested = false;
+			isWorkQueued = !_workQueue.empty();
+			if(isWorkQueued)
+			{
+				startWorkersIfRequired();
+			}
+		}
+		if(isWorkQueued)
+		{
+			_workAvailable.notify_all();
+		}
+		return discardedPipelineCount;
+	}
+
+
+	uint32_t AsyncShaderHasher::stop()
+	{
+		{
+			std::unique_lock lock(_workQueueMutex);
+			_isStopped = true;
+		}
+		return stopWorkers();
+	}
+
+
+	void AsyncShaderHasher::startWorkersIfRequired()
+	{
+		// caller owns the work queue lock. Workers are started on first use and not in DllMain, as threads can't be started under the loader lock.
+		if(!_workers.empty() || _stopRequested || _isStopped)
+		{
+			return;
+		}
+		for(int i = 0; i < ASYNC_HASHING_WORKER_COUNT; i++)
+		{
+			_workers.emplace_back(&AsyncShaderHasher::workerLoop, this);
+		}
+	}
+
+
+	void AsyncShaderHasher::workerLoop()
+	{
+		while(true)
+		{
+			PipelineWork work;
+			{
+				std::unique_lock lock(_workQueueMutex);
+				_workAvailable.wait(lock, [this] { return _stopRequested || !_workQueue.empty(); });
+				if(_stopRequested)
+				{
+					return;
+				}
+				work = std::move(_workQueue.front());
+				_workQueue.pop_front();
+			}
+			if(!isPendingPipeline(work.key.device, work.key.pipelineHandle))
+			{
+				// already destroyed
+				continue;
+			}
+			for(auto& shader : work.shaders)
+			{
+				if(shader.bytecode.size() > 0)
+				{
+					shader.hashes = _hashCache.calculateShaderHashes(shader.bytecode.data(), shader.bytecode.size());
+					_hashCache.storeShaderHashes(shader.key, shader.hashes);
+				}
+			}
+			completePipeline(work);
+		}
+	}
+
+
+	void AsyncShaderHasher::completePipeline(PipelineWork& work)
+	{
+		// the registration is done under the pending lock, so a cancel for this pipeline either happens before this, in which case the hashes are
+		// discarded, or after this, in which case the caller of the cancel removes the handle. It's registered right away rather than staged, so
+		// a pipeline which is no longer pending is always in the registry.
+		std::unique_lock lock(_pendingPipelinesMutex);
+		const auto it = _pendingTicketPerPipeline.find(work.key);
+		if(it == _pendingTicketPerPipeline.end() || it->second != work.ticket)
+		{
+			// destroyed, or destroyed and the handle was reused for a new pipeline which has its own work queued.
+			return;
+		}
+		for(const auto& shader : work.shaders)
+		{
+			shader.shaderManager->addHashHandlePair(shader.hashes.shaderHash, work.key.pipelineHandle, shader.hashes.codeSize, shader.hashes.fingerprint);
+		}
+		_pendingTicketPerPipeline.erase(it);
+		_pendingPipelineCount = _pendingTicketPerPipeline.size();
+	}
+}
@@ -0,0 +1,147 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "ShaderHashCache.h"
+#include "ShaderManager.h"
+
+namespace ShaderToggler
+{
+	/// <summary>
+	/// Hashes shader bytecode on a small pool of background threads so pipeline creation isn't stalled by the hashing. A pipeline with one or more
+	/// shaders which still have to be hashed is 'pending': it's registered with the shader managers only after all its shaders have been hashed.
+	/// Until then, binding the pipeline is treated as binding a pipeline without known shaders, so its draws are never blocked.
+	/// Pipelines are identified by their device and handle, as the handles of different devices can be the same. The device is an opaque pointer
+	/// which owns the shader managers of its pipelines.
+	/// </summary>
+	class AsyncShaderHasher
+	{
+	public:
+		/// <summary>
+		/// A shader of a pipeline which has to be registered with the shader manager specified. If the hash isn't known yet, the bytecode is a
+		/// copy of the shader's bytecode, which is hashed by a worker thread.
+		/// </summary>
+		struct PendingShader
+		{
+			ShaderManager* shaderManager;
+			ShaderHashCache::BytecodeKey key;
+			std::vector<uint8_t> bytecode;
+			ShaderHashCache::ShaderHashes hashes;
+		};
+
+		AsyncShaderHasher(ShaderHashCache& hashCache);
+
+		/// <summary>
+		/// Queues the shaders of the pipeline specified for hashing. When all shaders have been hashed, the hashes are registered with the shader
+		/// managers specified in the passed in shaders, before the pipeline stops being pending. Returns false if the hasher has been stopped, in
+		/// which case the shaders are left as they are and the caller has to hash them.
+		/// </summary>
+		/// <param name="device"></param>
+		/// <param name="pipelineHandle"></param>
+		/// <param name="shaders">moved into the queued work if true is returned</param>
+		/// <returns></returns>
+		bool addPipeline(const void* device, uint64_t pipelineHandle, std::vector<PendingShader>& shaders);
+		/// <summary>
+		/// Cancels the pending work for the pipeline specified, if any. Has to be called when the pipeline is destroyed.
+		/// </summary>
+		/// <param name="device"></param>
+		/// <param name="pipelineHandle"></param>
+		void cancelPipeline(const void* device, uint64_t pipelineHandle);
+		/// <summary>
+		/// Cancels the pending work for all pipelines of the device specified. When this returns, no worker uses the device's shader managers
+		/// anymore. Has to be called before the device is destroyed.
+		/// </summary>
+		/// <param name="device"></param>
+		void cancelDevice(const void* device);
+		bool isPendingPipeline(const void* device, uint64_t pipelineHandle);
+		/// <summary>
+		/// Signals the worker threads to stop and waits for them to exit. Work queued before this call is discarded, so its pipelines are no longer
+		/// pending. Work queued while the workers are stopping is kept, and new workers are started for it when they've stopped.
+		/// </summary>
+		/// <returns>the number of pipelines whose work was discarded</returns>
+		uint32_t stopWorkers();
+		/// <summary>
+		/// Stops the worker threads as in stopWorkers, and doesn't start them again: pipelines added afterwards are rejected. Has to be called
+		/// before the addon is unloaded.
+		/// </summary>
+		/// <returns>the number of pipelines whose work was discarded</returns>
+		uint32_t stop();
+
+		uint32_t getPendingPipelineCount() const { return _pendingPipelineCount; }
+
+	private:
+		struct PipelineKey
+		{
+			const void* device;
+			uint64_t pipelineHandle;
+
+			bool operator==(const PipelineKey& other) const { return device == other.device && pipelineHandle == other.pipelineHandle; }
+		};
+
+		struct PipelineKeyHash
+		{
+			size_t operator()(const PipelineKey& key) const { return std::hash<uint64_t>()(key.pipelineHandle ^ (reinterpret_cast<uintptr_t>(key.device) * 0x9E3779B97F4A7C15ull)); }
+		};
+
+		struct PipelineWork
+		{
+			PipelineKey key;
+			uint64_t ticket;
+			std::vector<PendingShader> shaders;
+		};
+
+		void startWorkersIfRequired();
+		void workerLoop();
+		void completePipeline(PipelineWork& work);
+
+		ShaderHashCache& _hashCache;
+		std::deque<PipelineWork> _workQueue;
+		std::mutex _workQueueMutex;
+		std::condition_variable _workAvailable;
+		std::unordered_map<PipelineKey, uint64_t, PipelineKeyHash> _pendingTicketPerPipeline;	// per pending pipeline the ticket of the work queued for it.
+		std::mutex _pendingPipelinesMutex;
+		std::atomic_uint32_t _pendingPipelineCount = 0;
+		uint64_t _lastTicket = 0;
+		std::vector<std::thread> _workers;
+		bool _stopRequested = false;		// the workers have to exit.
+		bool _isStopped = false;			// the workers aren't started again.
+	};
+}
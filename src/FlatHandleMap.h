@@ -0,0 +1,244 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace ShaderToggler
+{
+	/// <summary>
+	/// Open-addressing hash map with linear probing, keyed on pipeline handles. The slots are stored in one flat array, so a lookup is usually a
+	/// single cache line access instead of the pointer chasing of a node based map. Handle 0 is used to mark empty slots, so it can't be stored.
+	/// Deletion moves the following entries of the probe sequence back (backward shift), so no tombstones are left behind.
+	/// </summary>
+	template<typename TValue>
+	class FlatHandleMap
+	{
+	public:
+		FlatHandleMap(): _slots(MINIMUM_CAPACITY), _count(0)
+		{
+		}
+
+		/// <summary>
+		/// Returns a pointer to the value stored for the handle passed in, or nullptr if the handle isn't in the map. The pointer is valid until
+		/// the map is changed.
+		/// </summary>
+		/// <param name="handle"></param>
+		/// <returns></returns>
+		TValue* find(uint64_t handle)
+		{
+			if(handle == 0)
+			{
+				return nullptr;
+			}
+			const size_t mask = _slots.size() - 1;
+			for(size_t index = getIdealIndex(handle); ; index = (index + 1) & mask)
+			{
+				Slot& slot = _slots[index];
+				if(slot.handle == handle)
+				{
+					return &slot.value;
+				}
+				if(slot.handle == 0)
+				{
+					return nullptr;
+				}
+			}
+		}
+
+		const TValue* find(uint64_t handle) const
+		{
+			return const_cast<FlatHandleMap*>(this)->find(handle);
+		}
+
+		bool contains(uint64_t handle) const { return nullptr != find(handle); }
+
+		/// <summary>
+		/// Stores the value for the handle passed in, overwriting the value already stored for it, if any. Handle 0 is ignored.
+		/// </summary>
+		/// <param name="handle"></param>
+		/// <param name="value"></param>
+		void insertOrAssign(uint64_t handle, TValue value)
+		{
+			if(handle == 0)
+			{
+				return;
+			}
+			// keep the load factor at or below 3/4, so probe sequences stay short.
+			if((_count + 1) * 4 > _slots.size() * 3)
+			{
+				resize(_slots.size() * 2);
+			}
+			const size_t mask = _slots.size() - 1;
+			for(size_t index = getIdealIndex(handle); ; index = (index + 1) & mask)
+			{
+				Slot& slot = _slots[index];
+				if(slot.handle == handle)
+				{
+					slot.value = std::move(value);
+					return;
+				}
+				if(slot.handle == 0)
+				{
+					slot.handle = handle;
+					slot.value = std::move(value);
+					++_count;
+					return;
+				}
+			}
+		}
+
+		/// <summary>
+		/// Removes the handle passed in from the map. Returns true if it was in the map.
+		/// </summary>
+		/// <param name="handle"></param>
+		/// <returns></returns>
+		bool erase(uint64_t handle)
+		{
+			if(handle == 0)
+			{
+				return false;
+			}
+			const size_t mask = _slots.size() - 1;
+			size_t index = getIdealIndex(handle);
+			while(_slots[index].handle != handle)
+			{
+				if(_slots[index].handle == 0)
+				{
+					return false;
+				}
+				index = (index + 1) & mask;
+			}
+			// move the entries after the hole back into it, as long as that doesn't put them before their ideal slot.
+			size_t hole = index;
+			for(size_t next = (hole + 1) & mask; _slots[next].handle != 0; next = (next + 1) & mask)
+			{
+				const size_t ideal = getIdealIndex(_slots[next].handle);
+				// the entry can move if the hole is between its ideal slot and its current slot (wrapping around).
+				if(((hole - ideal) & mask) <= ((next - ideal) & mask))
+				{
+					_slots[hole] = std::move(_slots[next]);
+					hole = next;
+				}
+			}
+			_slots[hole] = Slot();
+			--_count;
+			return true;
+		}
+
+		/// <summary>
+		/// Makes room for the number of entries passed in, so adding up to that many entries doesn't rehash the map.
+		/// </summary>
+		/// <param name="count"></param>
+		void reserve(size_t count)
+		{
+			size_t capacity = _slots.size();
+			while(count * 4 > capacity * 3)
+			{
+				capacity *= 2;
+			}
+			if(capacity != _slots.size())
+			{
+				resize(capacity);
+			}
+		}
+
+		void clear()
+		{
+			_slots.assign(MINIMUM_CAPACITY, Slot());
+			_count = 0;
+		}
+
+		size_t size() const { return _count; }
+		/// <summary>
+		/// Returns the number of bytes allocated for the slots, not including memory allocated by the values themselves.
+		/// </summary>
+		size_t getMemoryUsage() const { return _slots.capacity() * sizeof(Slot); }
+
+		/// <summary>
+		/// Calls func(handle, value) for every entry in the map. The map can't be changed during the call, other than by changing the values.
+		/// </summary>
+		/// <param name="func"></param>
+		template<typename TFunc>
+		void forEach(TFunc func)
+		{
+			for(auto& slot : _slots)
+			{
+				if(slot.handle != 0)
+				{
+					func(slot.handle, slot.value);
+				}
+			}
+		}
+
+	private:
+		struct Slot
+		{
+			uint64_t handle = 0;
+			TValue value = {};
+		};
+
+		static constexpr size_t MINIMUM_CAPACITY = 64;
+
+		size_t getIdealIndex(uint64_t handle) const
+		{
+			// pipeline handles are pointers (or small indices) with zeroed low bits, so all bits are mixed into the low bits used as index.
+			handle ^= handle >> 33;
+			handle *= 0xFF51AFD7ED558CCDull;
+			handle ^= handle >> 33;
+			handle *= 0xC4CEB9FE1A85EC53ull;
+			handle ^= handle >> 33;
+			return static_cast<size_t>(handle) & (_slots.size() - 1);
+		}
+
+		void resize(size_t newCapacity)
+		{
+			std::vector<Slot> oldSlots(newCapacity);
+			oldSlots.swap(_slots);
+			_count = 0;
+			for(auto& slot : oldSlots)
+			{
+				if(slot.handle != 0)
+				{
+					insertOrAssign(slot.handle, std::move(slot.value));
+				}
+			}
+		}
+
+		std::vector<Slot> _slots;		// capacity is always a power of 2.
+		size_t _count;
+	};
+}
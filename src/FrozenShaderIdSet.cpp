@@ -0,0 +1,138 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+
+#include "FrozenShaderIdSet.h"
+
+namespace ShaderToggler
+{
+	FrozenShaderIdSet::FrozenShaderIdSet(const ShaderIdBitset& shaderIds)
+	{
+		std::vector<uint32_t> shaderIdsToStore;
+		shaderIds.forEachId([&](uint32_t shaderId) { shaderIdsToStore.push_back(shaderId); });
+		_size = shaderIdsToStore.size();
+		if(_size == 0)
+		{
+			return;
+		}
+		// ids are visited in ascending order.
+		const size_t rangeByteCount = (static_cast<size_t>(shaderIdsToStore.back() - shaderIdsToStore.front()) / 64 + 1) * sizeof(uint64_t);
+		const size_t perfectHashByteCount = (getSlotCount(_size) + _size / KEYS_PER_BUCKET + 1) * sizeof(uint32_t);
+		if(rangeByteCount > MAX_BITSET_BYTE_COUNT && perfectHashByteCount < rangeByteCount && buildPerfectHash(shaderIdsToStore))
+		{
+			return;
+		}
+		buildBitset(shaderIdsToStore);
+	}
+
+
+	bool FrozenShaderIdSet::buildPerfectHash(const std::vector<uint32_t>& shaderIds)
+	{
+		const uint32_t slotCount = getSlotCount(shaderIds.size());
+		const uint32_t bucketCount = static_cast<uint32_t>((shaderIds.size() + KEYS_PER_BUCKET - 1) / KEYS_PER_BUCKET);
+		std::vector<std::vector<uint32_t>> shaderIdsPerBucket(bucketCount);
+		for(const uint32_t shaderId : shaderIds)
+		{
+			shaderIdsPerBucket[mapToRange(hashShaderId(shaderId, 0), bucketCount)].push_back(shaderId);
+		}
+		// the largest buckets are placed first, while there are still many free slots.
+		std::vector<uint32_t> bucketOrder(bucketCount);
+		for(uint32_t bucket = 0; bucket < bucketCount; ++bucket)
+		{
+			bucketOrder[bucket] = bucket;
+		}
+		std::stable_sort(bucketOrder.begin(), bucketOrder.end(), [&](uint32_t a, uint32_t b) { return shaderIdsPerBucket[a].size() > shaderIdsPerBucket[b].size(); });
+
+		std::vector<bool> isSlotUsed(slotCount, false);
+		std::vector<uint32_t> displacements(bucketCount, 0);
+		std::vector<uint32_t> slots;
+		for(const uint32_t bucket : bucketOrder)
+		{
+			const std::vector<uint32_t>& bucketShaderIds = shaderIdsPerBucket[bucket];
+			if(bucketShaderIds.empty())
+			{
+				break;
+			}
+			bool isPlaced = false;
+			for(uint32_t displacement = 0; displacement < MAX_DISPLACEMENT && !isPlaced; ++displacement)
+			{
+				slots.clear();
+				isPlaced = true;
+				for(const uint32_t shaderId : bucketShaderIds)
+				{
+					const uint32_t slot = mapToRange(hashShaderId(shaderId, displacement + 1), slotCount);
+					if(isSlotUsed[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end())
+					{
+						isPlaced = false;
+						break;
+					}
+					slots.push_back(slot);
+				}
+				if(isPlaced)
+				{
+					displacements[bucket] = displacement;
+				}
+			}
+			if(!isPlaced)
+			{
+				return false;
+			}
+			for(const uint32_t slot : slots)
+			{
+				isSlotUsed[slot] = true;
+			}
+		}
+		_shaderIds.assign(slotCount, shaderIds.front());
+		for(const uint32_t shaderId : shaderIds)
+		{
+			const uint32_t bucket = mapToRange(hashShaderId(shaderId, 0), bucketCount);
+			_shaderIds[mapToRange(hashShaderId(shaderId, displacements[bucket] + 1), slotCount)] = shaderId;
+		}
+		_displacements = std::move(displacements);
+		_isPerfectHash = true;
+		return true;
+	}
+
+
+	void FrozenShaderIdSet::buildBitset(const std::vector<uint32_t>& shaderIds)
+	{
+		_firstShaderId = shaderIds.front();
+		_bitCount = shaderIds.back() - _firstShaderId + 1;
+		_words.assign((_bitCount + 63) / 64, 0);
+		for(const uint32_t shaderId : shaderIds)
+		{
+			const uint32_t offset = shaderId - _firstShaderId;
+			_words[offset >> 6] |= 1ull << (offset & 63);
+		}
+	}
+}
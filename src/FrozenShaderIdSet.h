@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ShaderIdBitset.h"
+
+namespace ShaderToggler
+{
+	/// <summary>
+	/// Immutable set of shader ids, built when the group configuration is compiled and only read after that. The set is stored as a bitset over the
+	/// range of its ids, which is the fastest to test. If that bitset would be too large to stay in the cache, a sparse set is stored with a
+	/// perfect hash over its ids instead (CHD: hash and displace), so a test is a hash, the load of the displacement of the id's bucket, the load of
+	/// the one id which can be at the resulting slot and a compare, without probing.
+	/// </summary>
+	class FrozenShaderIdSet
+	{
+	public:
+		FrozenShaderIdSet() = default;
+		explicit FrozenShaderIdSet(const ShaderIdBitset& shaderIds);
+
+		bool test(uint32_t shaderId) const
+		{
+			if(_isPerfectHash)
+			{
+				const uint32_t bucket = mapToRange(hashShaderId(shaderId, 0), static_cast<uint32_t>(_displacements.size()));
+				const uint32_t slot = mapToRange(hashShaderId(shaderId, _displacements[bucket] + 1), static_cast<uint32_t>(_shaderIds.size()));
+				return _shaderIds[slot] == shaderId;
+			}
+			// ids below the range wrap around to a large offset.
+			const uint32_t offset = shaderId - _firstShaderId;
+			return offset < _bitCount && ((_words[offset >> 6] >> (offset & 63)) & 1) != 0;
+		}
+
+		bool isEmpty() const { return _size == 0; }
+		size_t size() const { return _size; }
+		bool isPerfectHash() const { return _isPerfectHash; }
+
+	private:
+		static constexpr size_t MAX_BITSET_BYTE_COUNT = 4096;		// larger bitsets are replaced with a perfect hash if that's smaller.
+		static constexpr uint32_t KEYS_PER_BUCKET = 3;
+		// when no displacement is found for a bucket, the bitset is used. The set is built on the present thread, so the search is kept short: with
+		// a fifth of the slots free, a bucket is placed within a few hundred displacements.
+		static constexpr uint32_t MAX_DISPLACEMENT = 1 << 10;
+
+		static uint32_t hashShaderId(uint32_t shaderId, uint32_t seed)
+		{
+			uint64_t hash = (static_cast<uint64_t>(seed) << 32 | shaderId) * 0x9E3779B97F4A7C15ull;
+			hash ^= hash >> 29;
+			hash *= 0xBF58476D1CE4E5B9ull;
+			return static_cast<uint32_t>(hash >> 32);
+		}
+
+		// maps the hash to [0, range) with a multiply instead of a division.
+		static uint32_t mapToRange(uint32_t hash, uint32_t range) { return static_cast<uint32_t>((static_cast<uint64_t>(hash) * range) >> 32); }
+		// a quarter more slots than ids, so the last buckets to place still find free slots quickly.
+		static uint32_t getSlotCount(size_t shaderIdCount) { return static_cast<uint32_t>(shaderIdCount + shaderIdCount / 4 + 1); }
+
+		bool buildPerfectHash(const std::vector<uint32_t>& shaderIds);
+		void buildBitset(const std::vector<uint32_t>& shaderIds);
+
+		bool _isPerfectHash = false;
+		size_t _size = 0;
+		// perfect hash: per slot the id stored in it (the first id of the set if it's free, which only matches itself), and per bucket the displacement which maps the ids of the bucket to free slots.
+		std::vector<uint32_t> _shaderIds;
+		std::vector<uint32_t> _displacements;
+		// bitset: bit n is shader id _firstShaderId + n.
+		uint32_t _firstShaderId = 0;
+		uint32_t _bitCount = 0;
+		std::vector<uint64_t> _words;
+	};
+}
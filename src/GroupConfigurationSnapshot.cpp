@@ -0,0 +1,112 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "GroupConfigurationSnapshot.h"
+
+namespace ShaderToggler
+{
+	std::atomic<const CompiledGroupConfiguration*> GroupConfigurationSnapshot::s_current = new CompiledGroupConfiguration();
+	std::atomic_uint64_t GroupConfigurationSnapshot::s_epoch = 1;
+	std::atomic<GroupConfigurationSnapshot::ReaderRecord*> GroupConfigurationSnapshot::s_readers = nullptr;
+	std::vector<std::pair<uint64_t, const CompiledGroupConfiguration*>> GroupConfigurationSnapshot::s_retired;
+
+	GroupConfigurationSnapshot::ReadGuard::ReadGuard(): _record(getReaderRecord())
+	{
+		// nested guards on the same thread keep the epoch of the outer one.
+		_isOutermostGuard = _record->epoch.load(std::memory_order_relaxed) == 0;
+		if(_isOutermostGuard)
+		{
+			// the epoch has to be announced before the pointer is read, so the writer sees it when it checks if a replaced configuration is in use.
+			_record->epoch.store(s_epoch.load());
+		}
+		_configuration = s_current.load();
+	}
+
+
+	GroupConfigurationSnapshot::ReadGuard::~ReadGuard()
+	{
+		if(_isOutermostGuard)
+		{
+			_record->epoch.store(0, std::memory_order_release);
+		}
+	}
+
+
+	GroupConfigurationSnapshot::ReaderRecord* GroupConfigurationSnapshot::getReaderRecord()
+	{
+		thread_local ReaderRecord* record = nullptr;
+		if(nullptr == record)
+		{
+			record = new ReaderRecord();
+			ReaderRecord* head = s_readers.load();
+			do
+			{
+				record->next = head;
+			}
+			while(!s_readers.compare_exchange_weak(head, record));
+		}
+		return record;
+	}
+
+
+	void GroupConfigurationSnapshot::publish(const CompiledGroupConfiguration* toPublish)
+	{
+		const CompiledGroupConfiguration* replaced = s_current.exchange(toPublish);
+		// readers which announced this epoch or an earlier one could have read the replaced configuration, readers announcing a later one can't.
+		const uint64_t replacedInEpoch = s_epoch.fetch_add(1);
+		s_retired.emplace_back(replacedInEpoch, replaced);
+		deleteUnusedConfigurations();
+	}
+
+
+	void GroupConfigurationSnapshot::deleteUnusedConfigurations()
+	{
+		uint64_t oldestReadEpoch = UINT64_MAX;
+		for(ReaderRecord* record = s_readers.load(); nullptr != record; record = record->next)
+		{
+			const uint64_t epoch = record->epoch.load();
+			if(epoch != 0 && epoch < oldestReadEpoch)
+			{
+				oldestReadEpoch = epoch;
+			}
+		}
+		std::erase_if(s_retired, [oldestReadEpoch](const auto& retired)
+		{
+			if(retired.first < oldestReadEpoch)
+			{
+				delete retired.second;
+				return true;
+			}
+			return false;
+		});
+	}
+}
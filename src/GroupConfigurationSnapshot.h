@@ -0,0 +1,178 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "FrozenShaderIdSet.h"
+#include "PipelineRegistry.h"
+#include "ShaderIdBitset.h"
+#include "ShaderIdPrefilter.h"
+
+namespace ShaderToggler
+{
+	/// <summary>
+	/// Immutable, compiled form of the toggle group configuration which is read by the draw call threads. A new one is compiled and published
+	/// (see GroupConfigurationSnapshot) at a frame boundary when the groups have changed, which includes toggling a group.
+	/// </summary>
+	struct CompiledGroupConfiguration
+	{
+		/// <summary>
+		/// Sets per stage the union of the shader ids of the active groups which don't fit in the group mask. The sets are frozen and the
+		/// prefilter in front of the ones stored as a perfect hash is built here, as they're only read after the configuration has been published.
+		/// </summary>
+		/// <param name="shaderIdsPerStage">the union per stage, index is the ShaderStage</param>
+		void setActiveOverflowShaderIds(const ShaderIdBitset* shaderIdsPerStage)
+		{
+			for(size_t stageIndex = 0; stageIndex < SHADER_STAGE_COUNT; ++stageIndex)
+			{
+				if(shaderIdsPerStage[stageIndex].isEmpty())
+				{
+					continue;
+				}
+				activeOverflowShaderIdsPerStage[stageIndex] = FrozenShaderIdSet(shaderIdsPerStage[stageIndex]);
+				activeOverflowStageMask |= static_cast<uint8_t>(1u << stageIndex);
+				if(activeOverflowShaderIdsPerStage[stageIndex].isPerfectHash())
+				{
+					prefilteredOverflowStageMask |= static_cast<uint8_t>(1u << stageIndex);
+				}
+			}
+			if(prefilteredOverflowStageMask != 0)
+			{
+				activeOverflowPrefilter = ShaderIdPrefilter(shaderIdsPerStage, prefilteredOverflowStageMask);
+			}
+		}
+
+		/// <summary>
+		/// Returns true if a draw call with the passed in group mask and shaders has to be blocked by an active group.
+		/// </summary>
+		/// <param name="groupMask">the group slots containing one of the shaders</param>
+		/// <param name="stageMask">the stages which have a shader. Only these are tested</param>
+		/// <param name="shaderPerStage">the shader per stage, index is the ShaderStage</param>
+		/// <returns></returns>
+		bool isBlockedDrawCall(uint64_t groupMask, uint8_t stageMask, const PipelineShader* shaderPerStage) const
+		{
+			if((groupMask & activeGroupsMask) != 0)
+			{
+				return true;
+			}
+			// the active groups without a slot are tested through their union, so the cost doesn't depend on the number of groups.
+			bool isBlocked = false;
+			forEachShaderStage(stageMask & activeOverflowStageMask, [&](ShaderStage stage)
+			{
+				isBlocked |= isActiveOverflowShaderId(stage, shaderPerStage[static_cast<size_t>(stage)].shaderId);
+			});
+			return isBlocked;
+		}
+
+		bool isActiveOverflowShaderId(ShaderStage stage, uint32_t shaderId) const
+		{
+			const size_t stageIndex = static_cast<size_t>(stage);
+			if((prefilteredOverflowStageMask & (1u << stageIndex)) == 0)
+			{
+				// a bitset, which is tested with a single load already.
+				return activeOverflowShaderIdsPerStage[stageIndex].test(shaderId);
+			}
+			// a perfect hash takes three loads. Most draw calls aren't blocked, the prefilter rejects most of their shaders with one.
+			if(!activeOverflowPrefilter.mayContain(stage, shaderId))
+			{
+				ShaderIdPrefilter::addProbeToStatistics(true, false);
+				return false;
+			}
+			const bool isInSet = activeOverflowShaderIdsPerStage[stageIndex].test(shaderId);
+			ShaderIdPrefilter::addProbeToStatistics(false, !isInSet);
+			return isInSet;
+		}
+
+		uint64_t activeGroupsMask = 0;						// bit n is set if the group in slot n is active.
+		// per stage the union of the shader ids of the active groups which don't have a slot in the group mask. Index is the ShaderStage.
+		FrozenShaderIdSet activeOverflowShaderIdsPerStage[SHADER_STAGE_COUNT];
+		uint8_t activeOverflowStageMask = 0;				// the stages of which the union above isn't empty, bit n is ShaderStage n.
+		uint8_t prefilteredOverflowStageMask = 0;			// the stages of which the union above is a perfect hash, bit n is ShaderStage n.
+		ShaderIdPrefilter activeOverflowPrefilter;			// over the unions of the prefiltered stages.
+	};
+
+
+	/// <summary>
+	/// Publishes the current CompiledGroupConfiguration through an atomic pointer. Readers never lock: they announce the epoch they read in, in a
+	/// per-thread record, and a replaced configuration is only deleted once no reader announced an epoch at or before its replacement.
+	/// There's a single writer: publish is only called from the present/overlay thread.
+	/// </summary>
+	class GroupConfigurationSnapshot
+	{
+		struct ReaderRecord
+		{
+			std::atomic_uint64_t epoch = 0;		// 0 means the thread isn't reading.
+			ReaderRecord* next = nullptr;
+		};
+
+	public:
+		/// <summary>
+		/// Gives access to the current configuration for as long as the guard lives. Keep it short lived, it holds back the deletion of
+		/// configurations which are replaced meanwhile.
+		/// </summary>
+		class ReadGuard
+		{
+		public:
+			ReadGuard();
+			~ReadGuard();
+			ReadGuard(const ReadGuard&) = delete;
+			ReadGuard& operator=(const ReadGuard&) = delete;
+
+			const CompiledGroupConfiguration& get() const { return *_configuration; }
+
+		private:
+			ReaderRecord* _record;
+			bool _isOutermostGuard;
+			const CompiledGroupConfiguration* _configuration;
+		};
+
+		/// <summary>
+		/// Publishes the configuration passed in, which is owned by this class from then on, and deletes the replaced configurations no reader can
+		/// still be using.
+		/// </summary>
+		/// <param name="toPublish"></param>
+		static void publish(const CompiledGroupConfiguration* toPublish);
+
+	private:
+		static ReaderRecord* getReaderRecord();
+		static void deleteUnusedConfigurations();
+
+		static std::atomic<const CompiledGroupConfiguration*> s_current;
+		static std::atomic_uint64_t s_epoch;
+		static std::atomic<ReaderRecord*> s_readers;		// one record per thread which ever read a configuration. Never freed.
+		static std::vector<std::pair<uint64_t, const CompiledGroupConfiguration*>> s_retired;	// per replaced configuration the epoch it was replaced in.
+	};
+}
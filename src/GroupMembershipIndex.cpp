@@ -0,0 +1,140 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "GroupMembershipIndex.h"
+
+namespace ShaderToggler
+{
+	void GroupMembershipIndex::addGroupShaders(size_t slot, ShaderStage stage, const ShaderIdBitset& shaderIds)
+	{
+		if(slot >= SLOT_COUNT)
+		{
+			return;
+		}
+		const size_t stageIndex = static_cast<size_t>(stage);
+		shaderIds.forEachId([&](uint32_t shaderId)
+		{
+			setGroupMask(stageIndex, shaderId, getGroupMask(stage, shaderId) | (1ull << slot));
+		});
+	}
+
+
+	void GroupMembershipIndex::removeGroupShaders(size_t slot, ShaderStage stage, const ShaderIdBitset& shaderIds)
+	{
+		if(slot >= SLOT_COUNT)
+		{
+			return;
+		}
+		const size_t stageIndex = static_cast<size_t>(stage);
+		shaderIds.forEachId([&](uint32_t shaderId)
+		{
+			setGroupMask(stageIndex, shaderId, getGroupMask(stage, shaderId) & ~(1ull << slot));
+		});
+	}
+
+
+	void GroupMembershipIndex::removeSlot(size_t slot)
+	{
+		if(slot >= SLOT_COUNT)
+		{
+			return;
+		}
+		const uint64_t slotsBelow = (1ull << slot) - 1;
+		for(size_t stageIndex = 0; stageIndex < SHADER_STAGE_COUNT; ++stageIndex)
+		{
+			std::vector<uint64_t>& groupMaskPerShaderId = _groupMaskPerShaderId[stageIndex];
+			for(uint32_t shaderId = 0; shaderId < groupMaskPerShaderId.size(); ++shaderId)
+			{
+				const uint64_t groupMask = groupMaskPerShaderId[shaderId];
+				if((groupMask & ~slotsBelow) != 0)
+				{
+					setGroupMask(stageIndex, shaderId, (groupMask & slotsBelow) | ((groupMask >> 1) & ~slotsBelow));
+				}
+			}
+		}
+	}
+
+
+	uint64_t GroupMembershipIndex::getGroupMask(ShaderStage stage, uint32_t shaderId) const
+	{
+		const std::vector<uint64_t>& groupMaskPerShaderId = _groupMaskPerShaderId[static_cast<size_t>(stage)];
+		return shaderId < groupMaskPerShaderId.size() ? groupMaskPerShaderId[shaderId] : 0;
+	}
+
+
+	std::vector<ShaderGroupMask> GroupMembershipIndex::takeChangedGroupMasks(ShaderStage stage)
+	{
+		std::vector<ShaderGroupMask> toReturn;
+		ShaderIdBitset& changedShaderIds = _changedShaderIds[static_cast<size_t>(stage)];
+		changedShaderIds.forEachId([&](uint32_t shaderId)
+		{
+			toReturn.push_back({ shaderId, getGroupMask(stage, shaderId) });
+		});
+		changedShaderIds.clear();
+		return toReturn;
+	}
+
+
+	std::vector<ShaderGroupMask> GroupMembershipIndex::getGroupMasks(ShaderStage stage) const
+	{
+		std::vector<ShaderGroupMask> toReturn;
+		const std::vector<uint64_t>& groupMaskPerShaderId = _groupMaskPerShaderId[static_cast<size_t>(stage)];
+		for(uint32_t shaderId = 0; shaderId < groupMaskPerShaderId.size(); ++shaderId)
+		{
+			if(groupMaskPerShaderId[shaderId] != 0)
+			{
+				toReturn.push_back({ shaderId, groupMaskPerShaderId[shaderId] });
+			}
+		}
+		return toReturn;
+	}
+
+
+	void GroupMembershipIndex::setGroupMask(size_t stageIndex, uint32_t shaderId, uint64_t groupMask)
+	{
+		std::vector<uint64_t>& groupMaskPerShaderId = _groupMaskPerShaderId[stageIndex];
+		if(shaderId >= groupMaskPerShaderId.size())
+		{
+			if(groupMask == 0)
+			{
+				return;
+			}
+			groupMaskPerShaderId.resize(shaderId + 1, 0);
+		}
+		if(groupMaskPerShaderId[shaderId] == groupMask)
+		{
+			return;
+		}
+		groupMaskPerShaderId[shaderId] = groupMask;
+		_changedShaderIds[stageIndex].set(shaderId);
+	}
+}
@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ShaderIdBitset.h"
+#include "ShaderStage.h"
+
+namespace ShaderToggler
+{
+	/// <summary>
+	/// The mask of the toggle group slots containing a shader.
+	/// </summary>
+	struct ShaderGroupMask
+	{
+		uint32_t shaderId;
+		uint64_t groupMask;
+	};
+
+	/// <summary>
+	/// Inverted index of the toggle groups: per stage, per shader id the mask of the group slots containing the shader. Only the first SLOT_COUNT
+	/// groups have a slot. The index is updated incrementally when the shaders of a group change or a group is removed, and it records which shaders
+	/// got a different mask, so only those have to be passed on to the pipeline registries. Not thread safe, the caller serializes access.
+	/// </summary>
+	class GroupMembershipIndex
+	{
+	public:
+		static constexpr size_t SLOT_COUNT = 64;
+
+		/// <summary>
+		/// Adds the slot specified to the masks of the shaders passed in. Ignored for slots past SLOT_COUNT.
+		/// </summary>
+		/// <param name="slot"></param>
+		/// <param name="stage"></param>
+		/// <param name="shaderIds"></param>
+		void addGroupShaders(size_t slot, ShaderStage stage, const ShaderIdBitset& shaderIds);
+		/// <summary>
+		/// Removes the slot specified from the masks of the shaders passed in. Ignored for slots past SLOT_COUNT.
+		/// </summary>
+		/// <param name="slot"></param>
+		/// <param name="stage"></param>
+		/// <param name="shaderIds"></param>
+		void removeGroupShaders(size_t slot, ShaderStage stage, const ShaderIdBitset& shaderIds);
+		/// <summary>
+		/// Removes the slot specified from all masks and moves the slots after it down by one, as is done with the groups when one is removed. The
+		/// group which moves into the last slot has to be added by the caller.
+		/// </summary>
+		/// <param name="slot"></param>
+		void removeSlot(size_t slot);
+		uint64_t getGroupMask(ShaderStage stage, uint32_t shaderId) const;
+		/// <summary>
+		/// Returns the masks of the shaders of the stage specified which changed since the previous call, and forgets these changes.
+		/// </summary>
+		/// <param name="stage"></param>
+		/// <returns></returns>
+		std::vector<ShaderGroupMask> takeChangedGroupMasks(ShaderStage stage);
+		/// <summary>
+		/// Returns the masks of all shaders of the stage specified which are in a group.
+		/// </summary>
+		/// <param name="stage"></param>
+		/// <returns></returns>
+		std::vector<ShaderGroupMask> getGroupMasks(ShaderStage stage) const;
+
+	private:
+		void setGroupMask(size_t stageIndex, uint32_t shaderId, uint64_t groupMask);
+
+		// per stage, per shader id the mask of the group slots containing the shader. Only as large as the highest id in a group.
+		std::vector<uint64_t> _groupMaskPerShaderId[SHADER_STAGE_COUNT];
+		// per stage the shaders of which the mask changed since takeChangedGroupMasks was last called.
+		ShaderIdBitset _changedShaderIds[SHADER_STAGE_COUNT];
+	};
+}
@@ -35,12 +35,19 @@
 
 #include <imgui.h>
 #include <reshade.hpp>
-#include "crc32_hash.hpp"
+#include "AsyncShaderHasher.h"
+#include "PipelineRegistrationStaging.h"
+#include "ShaderHashCache.h"
 #include "ShaderManager.h"
+#include "ConfigurationGeneration.h"
+#include "GroupConfigurationSnapshot.h"
+#include "GroupMembershipIndex.h"
+#include "ShaderIdPrefilter.h"
 #include "CDataFile.h"
 #include "ToggleGroup.h"
 #include <vector>
 #include <filesystem>
+#include <mutex>
 
 using namespace reshade::api;
 using namespace ShaderToggler;
@@ -48,41 +55,260 @@ using namespace ShaderToggler;
 extern "C" __declspec(dllexport) const char *NAME = "Shader Toggler";
 extern "C" __declspec(dllexport) const char *DESCRIPTION = "Add-on which allows you to define groups of game shaders to toggle on/off with one key press.";
 
+/// <summary>
+/// The pipelines and shaders of a device. Every device has its own, so the pipeline handles of different devices don't mix and the binds on one device
+/// don't contend with the ones on another. The toggle groups are shared by all devices.
+/// </summary>
+struct __declspec(uuid("5DDDD8DC-A922-4446-8620-1C5397EA2E36")) DeviceDataContainer {
+	DeviceDataContainer() : shaderManagers{ { ShaderStage::Pixel, pipelineRegistry }, { ShaderStage::Vertex, pipelineRegistry }, { ShaderStage::Compute, pipelineRegistry },
+											{ ShaderStage::Hull, pipelineRegistry }, { ShaderStage::Domain, pipelineRegistry }, { ShaderStage::Geometry, pipelineRegistry } }
+	{
+	}
+
+	ShaderManager& getShaderManager(ShaderStage stage) { return shaderManagers[static_cast<size_t>(stage)]; }
+
+	PipelineRegistry pipelineRegistry;
+	ShaderManager shaderManagers[SHADER_STAGE_COUNT];		// index is the ShaderStage.
+};
+
 struct __declspec(uuid("038B03AA-4C75-443B-A695-752D80797037")) CommandListDataContainer {
-    uint64_t activePixelShaderPipeline;
-    uint64_t activeVertexShaderPipeline;
-	uint64_t activeComputeShaderPipeline;
+	DeviceDataContainer* deviceData;		// the data of the device the command list belongs to, obtained once when the command list is created.
+	uint64_t activePipelinePerStage[SHADER_STAGE_COUNT];		// index is the ShaderStage.
+	// the shaders of the active pipelines, resolved at bind time. Index is the ShaderStage.
+	PipelineShader activeShaderPerStage[SHADER_STAGE_COUNT];
+	uint8_t activeStageMask;				// the stages with an active shader, bit n is ShaderStage n. Draw calls only check these stages.
+	uint64_t groupMask;						// the group masks of the active shaders combined.
+	uint32_t groupMembershipGeneration;		// value of g_groupMembershipGeneration when the group masks were last obtained for all active shaders.
+	bool isDrawCallBlocked;					// the decision of the last draw call, valid as long as blockDecisionGeneration is the current ConfigurationGeneration.
+	uint32_t blockDecisionGeneration;		// 0 means there's no valid decision, e.g. because a pipeline was bound after the last draw call.
+	uint32_t trackingEpoch;					// value of g_trackingEpoch when a pipeline was last bound. If it differs, binds were skipped while idle.
 };
 
 #define FRAMECOUNT_COLLECTION_PHASE_DEFAULT 250;
+#define GROUP_MASK_SLOT_COUNT GroupMembershipIndex::SLOT_COUNT	// the first 64 toggle groups are tested with group masks, the ones after that through a union.
 #define HASH_FILE_NAME	"ShaderToggler.ini"
-
-static ShaderToggler::ShaderManager g_pixelShaderManager;
-static ShaderToggler::ShaderManager g_vertexShaderManager;
-static ShaderToggler::ShaderManager g_computeShaderManager;
+#define SKIPPED_CALLBACK_BATCH_SIZE 1024				// the number of skipped callbacks a thread counts before it adds them to the shared counter.
+
+static std::vector<DeviceDataContainer*> g_devices;				// the data of all live devices. Guarded by g_devicesMutex.
+static std::mutex g_devicesMutex;
+// the state every device has to know about, kept for the devices created later. Guarded by g_devicesMutex. Index is the ShaderStage.
+static GroupMembershipIndex g_groupMembershipIndex;				// updated on the present/overlay thread when the shaders of a group change.
+static std::unordered_map<uint32_t, uint64_t> g_knownFingerprintsPerStage[SHADER_STAGE_COUNT];
+static std::atomic<DeviceDataContainer*> g_shaderEditingDevice = nullptr;	// the device of which the shaders are collected and hunted for the group being edited.
+// per ShaderStage the pipeline stage it's bound to.
+static constexpr pipeline_stage PIPELINE_STAGE_PER_SHADER_STAGE[SHADER_STAGE_COUNT] = { pipeline_stage::pixel_shader, pipeline_stage::vertex_shader, pipeline_stage::compute_shader,
+																						 pipeline_stage::hull_shader, pipeline_stage::domain_shader, pipeline_stage::geometry_shader };
+// the stages which can be hunted with numpad 7-9, in the order numpad 0 switches between them. Pixel and vertex shaders have their own keys.
+static constexpr ShaderStage HUNTABLE_EXTRA_SHADER_STAGES[] = { ShaderStage::Compute, ShaderStage::Geometry, ShaderStage::Hull, ShaderStage::Domain };
+static ShaderToggler::ShaderHashCache g_shaderHashCache;
+static ShaderToggler::PipelineRegistrationStaging g_pipelineRegistrationStaging;
+static ShaderToggler::AsyncShaderHasher g_asyncShaderHasher(g_shaderHashCache);
+static atomic_bool g_asyncShaderHashingEnabled = false;
+static bool g_statisticsCollectionEnabled = false;					// true if the draw call statistics are also collected when no group is edited.
+static atomic_uint64_t g_skippedCallbackCount = 0;					// bind and draw callbacks which returned right away, reported in batches per thread.
 static KeyData g_keyCollector;
 static atomic_uint32_t g_activeCollectorFrameCounter = 0;
 static std::vector<ToggleGroup> g_toggleGroups;
+// guards the toggle groups and the shader editing state. Held by the present and overlay callbacks, and by destroy_device, which can run on
+// another thread. Recursive, as ReShade could raise an overlay callback from within another one.
+static std::recursive_mutex g_toggleGroupsMutex;
+static bool g_isGroupConfigurationChanged = false;				// true if the groups changed since the configuration was last published.
+static bool g_isGroupMembershipChanged = false;					// true if the shaders in the groups changed since the configuration was last published.
+static atomic_uint32_t g_groupMembershipGeneration = 0;			// incremented every time the shaders in the groups or the groups themselves change.
+static atomic_bool g_isDrawCallTrackingEnabled = true;			// false if the bind and draw callbacks return right away. Only changed on present.
+static atomic_uint32_t g_commandListDestroyCount = 0;				// incremented every time a command list is destroyed. Invalidates the cached command list data of all threads.
+static atomic_uint32_t g_trackingEpoch = 1;						// incremented every time draw call tracking is enabled again after being idle.
 static atomic_int g_toggleGroupIdKeyBindingEditing = -1;
 static atomic_int g_toggleGroupIdShaderEditing = -1;
 static float g_overlayOpacity = 1.0f;
+static size_t g_huntedExtraShaderStageIndex = 0;					// index in HUNTABLE_EXTRA_SHADER_STAGES of the stage hunted with numpad 7-9.
 static int g_startValueFramecountCollectionPhase = FRAMECOUNT_COLLECTION_PHASE_DEFAULT;
 static std::string g_iniFileName = "";
 
 /// <summary>
-/// Calculates a crc32 hash from the passed in shader bytecode. The hash is used to identity the shader in future runs.
+/// Calculates a crc32 hash from the passed in shader bytecode. The hash is used to identity the shader in future runs. If enabled, a 64-bit fingerprint
+/// is calculated as well. Bytecode which was hashed before for another pipeline isn't rehashed, its hashes are obtained from the hash cache.
 /// </summary>
 /// <param name="shaderData"></param>
 /// <returns></returns>
-static uint32_t calculateShaderHash(void* shaderData)
+static ShaderHashCache::ShaderHashes calculateShaderHashes(void* shaderData)
 {
 	if(nullptr==shaderData)
 	{
-		return 0;
+		return { 0, 0, 0 };
 	}
 
 	const auto shaderDesc = *static_cast<shader_desc *>(shaderData);
-	return compute_crc32(static_cast<const uint8_t *>(shaderDesc.code), shaderDesc.code_size);
+	return g_shaderHashCache.getShaderHashes(shaderDesc.code, shaderDesc.code_size);
+}
+
+
+/// <summary>
+/// Returns the shader manager of the device specified which manages the shaders of the passed in pipeline subobject type, or nullptr if we don't track
+/// shaders of that type.
+/// </summary>
+/// <param name="deviceData"></param>
+/// <param name="subobjectType"></param>
+/// <returns></returns>
+static ShaderManager* getShaderManagerForSubobjectType(DeviceDataContainer& deviceData, pipeline_subobject_type subobjectType)
+{
+	switch(subobjectType)
+	{
+		case pipeline_subobject_type::vertex_shader:
+			return &deviceData.getShaderManager(ShaderStage::Vertex);
+		case pipeline_subobject_type::hull_shader:
+			return &deviceData.getShaderManager(ShaderStage::Hull);
+		case pipeline_subobject_type::domain_shader:
+			return &deviceData.getShaderManager(ShaderStage::Domain);
+		case pipeline_subobject_type::geometry_shader:
+			return &deviceData.getShaderManager(ShaderStage::Geometry);
+		case pipeline_subobject_type::pixel_shader:
+			return &deviceData.getShaderManager(ShaderStage::Pixel);
+		case pipeline_subobject_type::compute_shader:
+			return &deviceData.getShaderManager(ShaderStage::Compute);
+	}
+	return nullptr;
+}
+
+
+static ShaderStage getHuntedExtraShaderStage()
+{
+	return HUNTABLE_EXTRA_SHADER_STAGES[g_huntedExtraShaderStageIndex];
+}
+
+
+static bool isAnyShaderManagerInHuntingMode()
+{
+	DeviceDataContainer* shaderEditingDevice = g_shaderEditingDevice;
+	if(nullptr == shaderEditingDevice)
+	{
+		return false;
+	}
+	for(auto& shaderManager : shaderEditingDevice->shaderManagers)
+	{
+		if(shaderManager.isInHuntingMode())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+/// <summary>
+/// Marks the group configuration as changed, so it's published again at the next frame boundary. Has to be called every time a group is toggled,
+/// or groups are added or removed. Only call this on the present/overlay thread.
+/// </summary>
+void markGroupConfigurationChanged()
+{
+	g_isGroupConfigurationChanged = true;
+}
+
+
+/// <summary>
+/// Marks the shaders in the groups as changed, so the group masks are updated and the group configuration is published again at the next
+/// frame boundary. Has to be called every time the shaders of a group change, or groups are added or removed. Only call this on the present/overlay thread.
+/// </summary>
+void markGroupMembershipChanged()
+{
+	g_isGroupMembershipChanged = true;
+	g_isGroupConfigurationChanged = true;
+}
+
+
+/// <summary>
+/// Returns the slot of the group passed in, which is its index in g_toggleGroups.
+/// </summary>
+/// <param name="group"></param>
+/// <returns></returns>
+static size_t getGroupSlot(const ToggleGroup& group)
+{
+	size_t slot = 0;
+	while(slot < g_toggleGroups.size() && g_toggleGroups[slot].getId() != group.getId())
+	{
+		++slot;
+	}
+	return slot;
+}
+
+
+/// <summary>
+/// Adds the shaders of the stage specified of the group in the slot specified to the group membership index, or removes them from it. Remove them
+/// before the shaders of a group change and add them again after.
+/// </summary>
+/// <param name="slot"></param>
+/// <param name="stage"></param>
+/// <param name="isAdd"></param>
+static void updateGroupMembershipIndex(size_t slot, ShaderStage stage, bool isAdd)
+{
+	if(slot >= g_toggleGroups.size())
+	{
+		return;
+	}
+	const ShaderIdBitset& shaderIds = g_toggleGroups[slot].getShaderIds(stage);
+	std::unique_lock lock(g_devicesMutex);
+	if(isAdd)
+	{
+		g_groupMembershipIndex.addGroupShaders(slot, stage, shaderIds);
+	}
+	else
+	{
+		g_groupMembershipIndex.removeGroupShaders(slot, stage, shaderIds);
+	}
+}
+
+
+/// <summary>
+/// Applies the changes made to the groups: passes the group masks of the shaders which changed in the group membership index to the pipeline registries
+/// of all devices, and compiles and publishes the configuration read by the draw calls. Called at frame boundaries, on the present thread.
+/// </summary>
+void publishGroupConfiguration()
+{
+	if(g_isGroupMembershipChanged)
+	{
+		std::unique_lock lock(g_devicesMutex);
+		for(size_t stageIndex = 0; stageIndex < SHADER_STAGE_COUNT; ++stageIndex)
+		{
+			const ShaderStage stage = static_cast<ShaderStage>(stageIndex);
+			const std::vector<ShaderGroupMask> changedGroupMasks = g_groupMembershipIndex.takeChangedGroupMasks(stage);
+			for(DeviceDataContainer* deviceData : g_devices)
+			{
+				deviceData->pipelineRegistry.setShaderGroupMasks(stage, changedGroupMasks);
+			}
+		}
+		++g_groupMembershipGeneration;
+		g_isGroupMembershipChanged = false;
+	}
+	if(!g_isGroupConfigurationChanged)
+	{
+		return;
+	}
+	CompiledGroupConfiguration* toPublish = new CompiledGroupConfiguration();
+	// the active groups without a slot in the group mask are merged per stage, and frozen into the published configuration.
+	ShaderIdBitset overflowShaderIdsPerStage[SHADER_STAGE_COUNT];
+	for(size_t slot = 0; slot < g_toggleGroups.size(); ++slot)
+	{
+		ToggleGroup& group = g_toggleGroups[slot];
+		if(!group.isActive())
+		{
+			continue;
+		}
+		if(slot < GROUP_MASK_SLOT_COUNT)
+		{
+			toPublish->activeGroupsMask |= 1ull << slot;
+		}
+		else
+		{
+			for(size_t stageIndex = 0; stageIndex < SHADER_STAGE_COUNT; ++stageIndex)
+			{
+				overflowShaderIdsPerStage[stageIndex].unionWith(group.getShaderIds(static_cast<ShaderStage>(stageIndex)));
+			}
+		}
+	}
+	toPublish->setActiveOverflowShaderIds(overflowShaderIdsPerStage);
+	GroupConfigurationSnapshot::publish(toPublish);
+	g_isGroupConfigurationChanged = false;
+	ConfigurationGeneration::increment();
 }
 
 
@@ -94,6 +320,7 @@ void addDefaultGroup()
 	ToggleGroup toAdd("Default", ToggleGroup::getNewGroupId());
 	toAdd.setToggleKey(VK_CAPITAL, false, false, false);
 	g_toggleGroups.push_back(toAdd);
+	markGroupMembershipChanged();
 }
 
 
@@ -109,6 +336,9 @@ void loadShaderTogglerIniFile()
 		// not there
 		return;
 	}
+	g_asyncShaderHashingEnabled = iniFile.GetBool("AsyncShaderHashing", "General");
+	g_statisticsCollectionEnabled = iniFile.GetBool("CollectStatistics", "General");
+	g_shaderHashCache.setFingerprintsEnabled(iniFile.GetBool("ShaderFingerprints", "General"));
 	int groupCounter = 0;
 	const int numberOfGroups = iniFile.GetInt("AmountGroups", "General");
 	if(numberOfGroups==INT_MIN)
@@ -124,11 +354,33 @@ void loadShaderTogglerIniFile()
 			g_toggleGroups.push_back(ToggleGroup("", ToggleGroup::getNewGroupId()));
 		}
 	}
-	for(auto& group: g_toggleGroups)
+	for(size_t slot = 0; slot < g_toggleGroups.size(); ++slot)
 	{
+		ToggleGroup& group = g_toggleGroups[slot];
 		group.loadState(iniFile, groupCounter);		// groupCounter is normally 0 or greater. For when the old format is detected, it's -1 (and there's 1 group).
 		groupCounter++;
+		for(size_t stageIndex = 0; stageIndex < SHADER_STAGE_COUNT; ++stageIndex)
+		{
+			updateGroupMembershipIndex(slot, static_cast<ShaderStage>(stageIndex), true);
+		}
+
+		// make the fingerprints stored with the groups known to the managers of all devices, so shaders with the same hash but different bytecode are flagged.
+		std::unique_lock lock(g_devicesMutex);
+		for(size_t stageIndex = 0; stageIndex < SHADER_STAGE_COUNT; ++stageIndex)
+		{
+			for(const auto& [shaderHash, fingerprint] : group.getShaderFingerprints(static_cast<ShaderStage>(stageIndex)))
+			{
+				g_knownFingerprintsPerStage[stageIndex][shaderHash] = fingerprint;
+				for(DeviceDataContainer* deviceData : g_devices)
+				{
+					deviceData->shaderManagers[stageIndex].addKnownFingerprint(shaderHash, fingerprint);
+				}
+			}
+		}
 	}
+	markGroupMembershipChanged();
+	// publish right away, so the groups which are active at startup are applied from the first frame.
+	publishGroupConfiguration();
 }
 
 
@@ -141,10 +393,29 @@ void saveShaderTogglerIniFile()
 	// groups are stored with "Group" + group counter, starting with 0.
 	CDataFile iniFile;
 	iniFile.SetInt("AmountGroups", g_toggleGroups.size(), "",  "General");
+	iniFile.SetBool("AsyncShaderHashing", g_asyncShaderHashingEnabled, "", "General");
+	iniFile.SetBool("CollectStatistics", g_statisticsCollectionEnabled, "", "General");
+	iniFile.SetBool("ShaderFingerprints", g_shaderHashCache.areFingerprintsEnabled(), "", "General");
 
+	// hashes stored without a fingerprint get the fingerprint of the shader with that hash seen in this session on any device, if any.
+	std::unordered_map<uint32_t, uint64_t> fingerprintsPerStage[SHADER_STAGE_COUNT];
+	{
+		std::unique_lock lock(g_devicesMutex);
+		for(DeviceDataContainer* deviceData : g_devices)
+		{
+			for(size_t stageIndex = 0; stageIndex < SHADER_STAGE_COUNT; ++stageIndex)
+			{
+				fingerprintsPerStage[stageIndex].merge(deviceData->shaderManagers[stageIndex].getShaderFingerprints());
+			}
+		}
+	}
 	int groupCounter = 0;
-	for(const auto& group: g_toggleGroups)
+	for(auto& group: g_toggleGroups)
 	{
+		for(size_t stageIndex = 0; stageIndex < SHADER_STAGE_COUNT; ++stageIndex)
+		{
+			group.upgradeFingerprints(static_cast<ShaderStage>(stageIndex), fingerprintsPerStage[stageIndex]);
+		}
 		group.saveState(iniFile, groupCounter);
 		groupCounter++;
 	}
@@ -155,40 +426,172 @@ void saveShaderTogglerIniFile()
 
 static void onInitCommandList(command_list *commandList)
 {
-	commandList->create_private_data<CommandListDataContainer>();
+	CommandListDataContainer& commandListData = commandList->create_private_data<CommandListDataContainer>();
+	commandListData.deviceData = &commandList->get_device()->get_private_data<DeviceDataContainer>();
 }
 
 
 static void onDestroyCommandList(command_list *commandList)
 {
+	// before the data is freed, so no thread can use its cached pointer to it anymore.
+	++g_commandListDestroyCount;
 	commandList->destroy_private_data<CommandListDataContainer>();
 }
 
+
+/// <summary>
+/// Returns the data of the command list passed in. A command list is mostly recorded by the same thread from one bind or draw to the next, so every thread
+/// caches the data of the command list it used last, which avoids the private data lookup of ReShade, keyed by GUID, for most binds and draws. The cached
+/// pointer is only used as long as no command list has been destroyed since, as a command list created after that could have the same address.
+/// </summary>
+/// <param name="commandList"></param>
+/// <returns></returns>
+static CommandListDataContainer& getCommandListData(command_list* commandList)
+{
+	thread_local command_list* cachedCommandList = nullptr;
+	thread_local CommandListDataContainer* cachedCommandListData = nullptr;
+	thread_local uint32_t cachedDestroyCount = 0;
+	const uint32_t destroyCount = g_commandListDestroyCount;
+	if(cachedCommandList == commandList && cachedDestroyCount == destroyCount)
+	{
+		return *cachedCommandListData;
+	}
+	CommandListDataContainer& commandListData = commandList->get_private_data<CommandListDataContainer>();
+	cachedCommandList = commandList;
+	cachedCommandListData = &commandListData;
+	cachedDestroyCount = destroyCount;
+	return commandListData;
+}
+
+/// <summary>
+/// Makes the shader passed in the active shader of the stage specified of the command list passed in.
+/// </summary>
+/// <param name="commandListData"></param>
+/// <param name="stage"></param>
+/// <param name="pipelineHandle">the pipeline the shader is part of</param>
+/// <param name="shader"></param>
+static void setActiveShader(CommandListDataContainer& commandListData, ShaderStage stage, uint64_t pipelineHandle, const PipelineShader& shader)
+{
+	const size_t stageIndex = static_cast<size_t>(stage);
+	commandListData.activePipelinePerStage[stageIndex] = pipelineHandle;
+	commandListData.activeShaderPerStage[stageIndex] = shader;
+	commandListData.activeStageMask |= static_cast<uint8_t>(1u << stageIndex);
+}
+
+
+static void clearActiveShader(CommandListDataContainer& commandListData, ShaderStage stage)
+{
+	const size_t stageIndex = static_cast<size_t>(stage);
+	commandListData.activePipelinePerStage[stageIndex] = -1;
+	commandListData.activeShaderPerStage[stageIndex] = { 0, 0, 0 };
+	commandListData.activeStageMask &= static_cast<uint8_t>(~(1u << stageIndex));
+}
+
+
+static void clearActiveShaders(CommandListDataContainer& commandListData)
+{
+	for(size_t stageIndex = 0; stageIndex < SHADER_STAGE_COUNT; ++stageIndex)
+	{
+		clearActiveShader(commandListData, static_cast<ShaderStage>(stageIndex));
+	}
+}
+
+
 static void onResetCommandList(command_list *commandList)
 {
-	CommandListDataContainer &commandListData = commandList->get_private_data<CommandListDataContainer>();
-	commandListData.activePixelShaderPipeline = -1;
-	commandListData.activeVertexShaderPipeline = -1;
-	commandListData.activeComputeShaderPipeline = -1;
+	CommandListDataContainer &commandListData = getCommandListData(commandList);
+	clearActiveShaders(commandListData);
+	commandListData.groupMask = 0;
+	commandListData.blockDecisionGeneration = 0;
+}
+
+
+/// <summary>
+/// Combines the group masks of the active shaders of the command list passed in, after one of them has changed.
+/// </summary>
+/// <param name="commandListData"></param>
+static void updateCommandListGroupMask(CommandListDataContainer& commandListData)
+{
+	uint64_t groupMask = 0;
+	forEachShaderStage(commandListData.activeStageMask, [&](ShaderStage stage)
+	{
+		groupMask |= commandListData.activeShaderPerStage[static_cast<size_t>(stage)].groupMask;
+	});
+	commandListData.groupMask = groupMask;
+	// the active shaders changed, so the decision of the previous draw call isn't valid anymore.
+	commandListData.blockDecisionGeneration = 0;
+}
+
+
+/// <summary>
+/// Registers the shaders of the passed in pipeline with the shader managers. Shaders which haven't been hashed before are copied and hashed on a
+/// background thread, in which case that thread completes the registration of the pipeline.
+/// </summary>
+/// <param name="subobjectCount"></param>
+/// <param name="subobjects"></param>
+/// <param name="pipelineHandle"></param>
+static void addPipelineForAsyncHashing(DeviceDataContainer& deviceData, uint32_t subobjectCount, const pipeline_subobject *subobjects, pipeline pipelineHandle)
+{
+	std::vector<AsyncShaderHasher::PendingShader> shaders;
+	bool hashingRequired = false;
+	for(uint32_t i = 0; i < subobjectCount; ++i)
+	{
+		ShaderManager* shaderManager = getShaderManagerForSubobjectType(deviceData, subobjects[i].type);
+		if(nullptr == shaderManager || nullptr == subobjects[i].data)
+		{
+			continue;
+		}
+		const auto shaderDesc = static_cast<const shader_desc *>(subobjects[i].data);
+		if(nullptr == shaderDesc->code || shaderDesc->code_size <= 0)
+		{
+			continue;
+		}
+		AsyncShaderHasher::PendingShader toAdd = { shaderManager, ShaderHashCache::createKey(shaderDesc->code, shaderDesc->code_size), {}, { 0, 0, 0 } };
+		if(!g_shaderHashCache.tryGetShaderHashes(toAdd.key, toAdd.hashes))
+		{
+			const auto code = static_cast<const uint8_t *>(shaderDesc->code);
+			toAdd.bytecode.assign(code, code + shaderDesc->code_size);
+			hashingRequired = true;
+		}
+		shaders.push_back(std::move(toAdd));
+	}
+	if(hashingRequired && g_asyncShaderHasher.addPipeline(&deviceData, pipelineHandle.handle, shaders))
+	{
+		return;
+	}
+	// all hashes were already known, or the hasher has been stopped as the addon is being unloaded.
+	for(auto& shader : shaders)
+	{
+		if(shader.bytecode.size() > 0)
+		{
+			shader.hashes = g_shaderHashCache.calculateShaderHashes(shader.bytecode.data(), shader.bytecode.size());
+			g_shaderHashCache.storeShaderHashes(shader.key, shader.hashes);
+		}
+	}
+	for(const auto& shader : shaders)
+	{
+		g_pipelineRegistrationStaging.addHashHandlePair(shader.shaderManager, shader.hashes.shaderHash, pipelineHandle.handle, shader.hashes.codeSize, shader.hashes.fingerprint);
+	}
 }
 
 
 static void onInitPipeline(device *device, pipeline_layout, uint32_t subobjectCount, const pipeline_subobject *subobjects, pipeline pipelineHandle)
 {
+	DeviceDataContainer& deviceData = device->get_private_data<DeviceDataContainer>();
+	if(g_asyncShaderHashingEnabled)
+	{
+		addPipelineForAsyncHashing(deviceData, subobjectCount, subobjects, pipelineHandle);
+		return;
+	}
+
 	// shader has been created, we will now create a hash and store it with the handle we got.
 	for (uint32_t i = 0; i < subobjectCount; ++i)
 	{
-		switch (subobjects[i].type)
+		ShaderManager* shaderManager = getShaderManagerForSubobjectType(deviceData, subobjects[i].type);
+		if(nullptr != shaderManager)
 		{
-			case pipeline_subobject_type::vertex_shader:
-				g_vertexShaderManager.addHashHandlePair(calculateShaderHash(subobjects[i].data), pipelineHandle.handle);
-				break;
-			case pipeline_subobject_type::pixel_shader:
-				g_pixelShaderManager.addHashHandlePair(calculateShaderHash(subobjects[i].data), pipelineHandle.handle);
-				break;
-			case pipeline_subobject_type::compute_shader:
-				g_computeShaderManager.addHashHandlePair(calculateShaderHash(subobjects[i].data), pipelineHandle.handle);
-				break;
+			const auto hashes = calculateShaderHashes(subobjects[i].data);
+			g_pipelineRegistrationStaging.addHashHandlePair(shaderManager, hashes.shaderHash, pipelineHandle.handle, hashes.codeSize, hashes.fingerprint);
 		}
 	}
 }
@@ -196,9 +599,23 @@ static void onInitPipeline(device *device, pipeline_layout, uint32_t subobjectCo
 
 static void onDestroyPipeline(device *device, pipeline pipelineHandle)
 {
-	g_pixelShaderManager.removeHandle(pipelineHandle.handle);
-	g_vertexShaderManager.removeHandle(pipelineHandle.handle);
-	g_computeShaderManager.removeHandle(pipelineHandle.handle);
+	DeviceDataContainer& deviceData = device->get_private_data<DeviceDataContainer>();
+	// first cancel pending hashing work, so it can't register the handle after it has been removed below.
+	g_asyncShaderHasher.cancelPipeline(&deviceData, pipelineHandle.handle);
+	// the pipeline could still be staged for registration.
+	if(g_pipelineRegistrationStaging.hasStagedShaders())
+	{
+		g_pipelineRegistrationStaging.flush();
+	}
+	PipelineRecord removedPipeline;
+	if(!deviceData.pipelineRegistry.removePipeline(pipelineHandle.handle, removedPipeline))
+	{
+		return;
+	}
+	forEachShaderStage(removedPipeline.stageMask, [&](ShaderStage stage)
+	{
+		deviceData.getShaderManager(stage).removeShader(removedPipeline.getShader(stage).shaderHash);
+	});
 }
 
 
@@ -227,11 +644,70 @@ static void displayShaderManagerInfo(ShaderManager& toDisplay, const char* shade
 static void displayShaderManagerStats(ShaderManager& toDisplay, const char* shaderType)
 {
 	ImGui::Text("# of pipelines with %s shaders: %d. # of different %s shaders gathered: %d.", shaderType, toDisplay.getPipelineCount(), shaderType, toDisplay.getShaderCount());
+	if(toDisplay.getCollidingShaderHashCount() > 0)
+	{
+		ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.4f, 0.0f, 1.0f));
+		ImGui::Text("# of %s shader hashes shared by different shaders: %d.", shaderType, toDisplay.getCollidingShaderHashCount());
+		ImGui::PopStyleColor();
+	}
+}
+
+
+static void displayPipelineLookupCacheStats(const PipelineRegistry& pipelineRegistry)
+{
+	uint64_t lookupCount = 0;
+	uint64_t hitCount = 0;
+	pipelineRegistry.getLookupCacheStatistics(lookupCount, hitCount);
+	const double hitRate = lookupCount > 0 ? 100.0 * static_cast<double>(hitCount) / static_cast<double>(lookupCount) : 0.0;
+	ImGui::Text("Pipeline lookup cache hit rate: %.1f%% of %llu lookups.", hitRate, lookupCount);
+}
+
+
+static void displayOverflowGroupPrefilterStats()
+{
+	uint64_t probeCount = 0;
+	uint64_t rejectedCount = 0;
+	uint64_t falsePositiveCount = 0;
+	ShaderIdPrefilter::getStatistics(probeCount, rejectedCount, falsePositiveCount);
+	if(probeCount == 0)
+	{
+		// only groups which don't fit in the group mask and are stored as a perfect hash are prefiltered.
+		return;
+	}
+	// the rate is of the probes of shaders which aren't in the groups, the ones the prefilter should reject.
+	const uint64_t notInGroupsCount = rejectedCount + falsePositiveCount;
+	const double falsePositiveRate = notInGroupsCount > 0 ? 100.0 * static_cast<double>(falsePositiveCount) / static_cast<double>(notInGroupsCount) : 0.0;
+	ImGui::Text("Group prefilter: %llu of %llu probes rejected. False positive rate: %.2f%%.", rejectedCount, probeCount, falsePositiveRate);
+}
+
+
+static void displaySkippedCallbackStats()
+{
+	if(!g_statisticsCollectionEnabled)
+	{
+		// otherwise the statistics are only collected while a group is edited, during which no callback is skipped.
+		return;
+	}
+	ImGui::Text("# of bind and draw callbacks skipped while no group was active: %llu.", g_skippedCallbackCount.load(std::memory_order_relaxed));
+}
+
+
+static void displayPipelineRegistryMemoryStats(PipelineRegistry& pipelineRegistry)
+{
+	uint32_t pipelineCount = 0;
+	size_t pipelineByteCount = 0;
+	size_t shaderByteCount = 0;
+	pipelineRegistry.getMemoryStatistics(pipelineCount, pipelineByteCount, shaderByteCount);
+	// the tables per shader are left out of the figure per pipeline, as they don't grow with the number of pipelines.
+	const double bytesPerPipeline = pipelineCount > 0 ? static_cast<double>(pipelineByteCount) / static_cast<double>(pipelineCount) : 0.0;
+	ImGui::Text("# of pipelines: %d. Memory used: %llu KB, %.1f bytes per pipeline. Per shader: %llu KB.", pipelineCount,
+				static_cast<uint64_t>(pipelineByteCount / 1024), bytesPerPipeline, static_cast<uint64_t>(shaderByteCount / 1024));
 }
 
 
 static void onReshadeOverlay(reshade::api::effect_runtime *runtime)
 {
+	std::unique_lock groupsLock(g_toggleGroupsMutex);
 	if(g_toggleGroupIdShaderEditing>=0)
 	{
 		ImGui::SetNextWindowBgAlpha(g_overlayOpacity);
@@ -252,9 +728,30 @@ static void onReshadeOverlay(reshade::api::effect_runtime *runtime)
 			}
 		}
 		
-		displayShaderManagerStats(g_vertexShaderManager, "vertex");
-		displayShaderManagerStats(g_pixelShaderManager, "pixel");
-		displayShaderManagerStats(g_computeShaderManager, "compute");
+		// the statistics are of the device this overlay is shown for.
+		DeviceDataContainer& deviceData = runtime->get_device()->get_private_data<DeviceDataContainer>();
+		for(auto& shaderManager : deviceData.shaderManagers)
+		{
+			// the stages most games don't use are only listed when they're used.
+			if(shaderManager.getStage() <= ShaderStage::Compute || shaderManager.getPipelineCount() > 0)
+			{
+				displayShaderManagerStats(shaderManager, getShaderStageName(shaderManager.getStage()));
+			}
+		}
+		displayPipelineRegistryMemoryStats(deviceData.pipelineRegistry);
+		{
+			std::unique_lock lock(g_devicesMutex);
+			ImGui::Text("# of devices: %d.", static_cast<int>(g_devices.size()));
+		}
+		ImGui::Text("# of pipeline shaders registered: %llu, in %llu batches.", g_pipelineRegistrationStaging.getRegisteredShaderCount(), g_pipelineRegistrationStaging.getBatchCount());
+		displayPipelineLookupCacheStats(deviceData.pipelineRegistry);
+		displayOverflowGroupPrefilterStats();
+		displaySkippedCallbackStats();
+		ImGui::Text("Shader hash cache hits: %d. Misses: %d.", g_shaderHashCache.getHitCount(), g_shaderHashCache.getMissCount());
+		if(g_asyncShaderHashingEnabled)
+		{
+			ImGui::Text("# of pipelines waiting for their shaders to be hashed: %d.", g_asyncShaderHasher.getPendingPipelineCount());
+		}
 
 		if(g_activeCollectorFrameCounter > 0)
 		{
@@ -263,91 +760,136 @@ static void onReshadeOverlay(reshade::api::effect_runtime *runtime)
 		}
 		else
 		{
-			if(g_vertexShaderManager.isInHuntingMode() || g_pixelShaderManager.isInHuntingMode() || g_computeShaderManager.isInHuntingMode())
+			if(isAnyShaderManagerInHuntingMode())
 			{
 				ImGui::Text("Editing the shaders for group: %s", editingGroupName.c_str());
+				ImGui::Text("Numpad 7-9 hunt the %s shaders, Numpad 0 switches the stage.", getShaderStageName(getHuntedExtraShaderStage()));
+			}
+			DeviceDataContainer* shaderEditingDevice = g_shaderEditingDevice;
+			if(nullptr != shaderEditingDevice)
+			{
+				for(auto& shaderManager : shaderEditingDevice->shaderManagers)
+				{
+					displayShaderManagerInfo(shaderManager, getShaderStageName(shaderManager.getStage()));
+				}
 			}
-			displayShaderManagerInfo(g_vertexShaderManager, "vertex");
-			displayShaderManagerInfo(g_pixelShaderManager, "pixel");
-			displayShaderManagerInfo(g_computeShaderManager, "compute");
 		}
 		ImGui::End();
 	}
 }
 
 
+/// <summary>
+/// Makes sure the state of the command list passed in is from the current tracking epoch. If not, the pipelines bound to it while draw call tracking
+/// was disabled are unknown, so the state is reset.
+/// </summary>
+/// <param name="commandListData"></param>
+static void ensureCurrentTrackingEpoch(CommandListDataContainer& commandListData)
+{
+	const uint32_t trackingEpoch = g_trackingEpoch;
+	if(commandListData.trackingEpoch == trackingEpoch)
+	{
+		return;
+	}
+	clearActiveShaders(commandListData);
+	updateCommandListGroupMask(commandListData);
+	commandListData.trackingEpoch = trackingEpoch;
+}
+
+
+/// <summary>
+/// Returns true if the bind and draw callbacks have to do their work. If not, they return right away so an idle addon adds almost no cost to the
+/// game's draw calls.
+/// </summary>
+static bool isDrawCallTrackingEnabled()
+{
+	return g_isDrawCallTrackingEnabled.load(std::memory_order_relaxed);
+}
+
+
+/// <summary>
+/// Counts a bind or draw callback which returned right away as draw call tracking is disabled, if the statistics are collected.
+/// </summary>
+static void countSkippedCallback()
+{
+	if(!ShaderIdPrefilter::isCollectingStatistics())
+	{
+		return;
+	}
+	// batched per thread, so the render threads don't contend on the shared counter.
+	thread_local uint32_t skippedCallbackCount = 0;
+	if(++skippedCallbackCount >= SKIPPED_CALLBACK_BATCH_SIZE)
+	{
+		g_skippedCallbackCount.fetch_add(skippedCallbackCount, std::memory_order_relaxed);
+		skippedCallbackCount = 0;
+	}
+}
+
+
 static void onBindPipeline(command_list* commandList, pipeline_stage stages, pipeline pipelineHandle)
 {
+	if(!isDrawCallTrackingEnabled())
+	{
+		countSkippedCallback();
+		return;
+	}
 	if(nullptr != commandList && pipelineHandle.handle != 0)
 	{
-		const bool handleHasPixelShaderAttached = g_pixelShaderManager.isKnownHandle(pipelineHandle.handle);
-		const bool handleHasVertexShaderAttached = g_vertexShaderManager.isKnownHandle(pipelineHandle.handle);
-		const bool handleHasComputeShaderAttached = g_computeShaderManager.isKnownHandle(pipelineHandle.handle);
-		if(!handleHasPixelShaderAttached && !handleHasVertexShaderAttached && !handleHasComputeShaderAttached)
+		CommandListDataContainer& commandListData = getCommandListData(commandList);
+		DeviceDataContainer& deviceData = *commandListData.deviceData;
+		PipelineRecord pipelineRecord;
+		bool isKnownPipeline = deviceData.pipelineRegistry.tryGetPipeline(pipelineHandle.handle, pipelineRecord);
+		if(!isKnownPipeline && g_pipelineRegistrationStaging.hasStagedShaders() && g_pipelineRegistrationStaging.flushCallingThread())
 		{
-			// draw call with unknown handle, don't collect it
-			return;
+			// the pipeline could have been staged for registration by this thread.
+			isKnownPipeline = deviceData.pipelineRegistry.tryGetPipeline(pipelineHandle.handle, pipelineRecord);
 		}
-		CommandListDataContainer& commandListData = commandList->get_private_data<CommandListDataContainer>();
-		// always do the following code as that has to run for every bind on a pipeline:
-		if(g_activeCollectorFrameCounter > 0)
+		bool isUnregisteredPipeline = false;
+		if(!isKnownPipeline)
 		{
-			// in collection mode
-			if(handleHasPixelShaderAttached)
-			{
-				g_pixelShaderManager.addActivePipelineHandle(pipelineHandle.handle);
-			}
-			if(handleHasVertexShaderAttached)
-			{
-				g_vertexShaderManager.addActivePipelineHandle(pipelineHandle.handle);
-			}
-			if(handleHasComputeShaderAttached)
-			{
-				g_computeShaderManager.addActivePipelineHandle(pipelineHandle.handle);
-			}
-		}
-		else
-		{
-			commandListData.activePixelShaderPipeline = handleHasPixelShaderAttached ? pipelineHandle.handle : commandListData.activePixelShaderPipeline;
-			commandListData.activeVertexShaderPipeline = handleHasVertexShaderAttached ? pipelineHandle.handle : commandListData.activeVertexShaderPipeline;
-			commandListData.activeComputeShaderPipeline = handleHasComputeShaderAttached ? pipelineHandle.handle : commandListData.activeComputeShaderPipeline;
+			// a pipeline is registered before it stops being pending or staged, so if that happened after the lookups above, it's found now.
+			isUnregisteredPipeline = g_asyncShaderHasher.isPendingPipeline(&deviceData, pipelineHandle.handle) || g_pipelineRegistrationStaging.isStagedPipeline(pipelineHandle.handle);
+			isKnownPipeline = deviceData.pipelineRegistry.tryGetPipeline(pipelineHandle.handle, pipelineRecord);
 		}
-		if((stages & pipeline_stage::pixel_shader) == pipeline_stage::pixel_shader)
+		if(!isKnownPipeline)
 		{
-			if(handleHasPixelShaderAttached)
+			if(isUnregisteredPipeline)
 			{
-				if(g_activeCollectorFrameCounter > 0)
+				// the shaders of this pipeline are still being hashed, or are staged for registration by another thread. Until it's
+				// registered, the stages it's bound to have no known shader, so draws using this pipeline are never blocked, and not blocked by
+				// the previously bound pipeline either.
+				ensureCurrentTrackingEpoch(commandListData);
+				for(size_t stageIndex = 0; stageIndex < SHADER_STAGE_COUNT; ++stageIndex)
 				{
-					// in collection mode
-					g_pixelShaderManager.addActivePipelineHandle(pipelineHandle.handle);
+					if((stages & PIPELINE_STAGE_PER_SHADER_STAGE[stageIndex]) == PIPELINE_STAGE_PER_SHADER_STAGE[stageIndex])
+					{
+						clearActiveShader(commandListData, static_cast<ShaderStage>(stageIndex));
+					}
 				}
-				commandListData.activePixelShaderPipeline = pipelineHandle.handle;
+				updateCommandListGroupMask(commandListData);
 			}
+			// draw call with unknown handle, don't collect it
+			return;
 		}
-		if((stages & pipeline_stage::vertex_shader) == pipeline_stage::vertex_shader)
+		ensureCurrentTrackingEpoch(commandListData);
+		// only the shaders of the device of which the shaders are edited are collected.
+		const bool isCollecting = g_activeCollectorFrameCounter > 0 && g_shaderEditingDevice == &deviceData;
+		// only the stages the pipeline has a shader for are visited.
+		forEachShaderStage(pipelineRecord.stageMask, [&](ShaderStage stage)
 		{
-			if(handleHasVertexShaderAttached)
+			const PipelineShader& shader = pipelineRecord.getShader(stage);
+			if(isCollecting)
 			{
-				if(g_activeCollectorFrameCounter > 0)
-				{
-					// in collection mode
-					g_vertexShaderManager.addActivePipelineHandle(pipelineHandle.handle);
-				}
-				commandListData.activeVertexShaderPipeline = pipelineHandle.handle;
+				deviceData.getShaderManager(stage).addActiveShader(shader.shaderHash);
 			}
-		}
-		if((stages & pipeline_stage::compute_shader) == pipeline_stage::compute_shader)
-		{
-			if(handleHasComputeShaderAttached)
+			// in collection mode only the stages the pipeline is bound to become active.
+			const pipeline_stage pipelineStage = PIPELINE_STAGE_PER_SHADER_STAGE[static_cast<size_t>(stage)];
+			if(!isCollecting || (stages & pipelineStage) == pipelineStage)
 			{
-				if(g_activeCollectorFrameCounter > 0)
-				{
-					// in collection mode
-					g_computeShaderManager.addActivePipelineHandle(pipelineHandle.handle);
-				}
-				commandListData.activeComputeShaderPipeline = pipelineHandle.handle;
+				setActiveShader(commandListData, stage, pipelineHandle.handle, shader);
 			}
-		}
+		});
+		updateCommandListGroupMask(commandListData);
 	}
 }
 
@@ -364,31 +906,56 @@ bool blockDrawCallForCommandList(command_list* commandList)
 		return false;
 	}
 
-	const CommandListDataContainer &commandListData = commandList->get_private_data<CommandListDataContainer>();
-	uint32_t shaderHash = g_pixelShaderManager.getShaderHash(commandListData.activePixelShaderPipeline);
-	bool blockCall = g_pixelShaderManager.isBlockedShader(shaderHash);
-	for(auto& group : g_toggleGroups)
+	CommandListDataContainer &commandListData = getCommandListData(commandList);
+	if(commandListData.trackingEpoch != g_trackingEpoch)
 	{
-		blockCall |= group.isBlockedPixelShader(shaderHash);
+		// no pipeline has been bound since tracking was enabled again, so which pipelines are active isn't known.
+		return false;
 	}
-	shaderHash = g_vertexShaderManager.getShaderHash(commandListData.activeVertexShaderPipeline);
-	blockCall |= g_vertexShaderManager.isBlockedShader(shaderHash);
-	for(auto& group : g_toggleGroups)
+	// read before anything else, so if the configuration changes while the decision is made, the decision isn't used for the next draw call.
+	const uint32_t configurationGeneration = ConfigurationGeneration::get();
+	if(commandListData.blockDecisionGeneration == configurationGeneration)
 	{
-		blockCall |= group.isBlockedVertexShader(shaderHash);
+		return commandListData.isDrawCallBlocked;
 	}
-	shaderHash = g_computeShaderManager.getShaderHash(commandListData.activeComputeShaderPipeline);
-	blockCall |= g_computeShaderManager.isBlockedShader(shaderHash);
-	for(auto& group : g_toggleGroups)
+	DeviceDataContainer& deviceData = *commandListData.deviceData;
+	const uint32_t groupMembershipGeneration = g_groupMembershipGeneration;
+	if(commandListData.groupMembershipGeneration != groupMembershipGeneration)
+	{
+		// the groups changed after the group masks were obtained, so they're outdated. The generation is read before the masks, so if the groups change
+		// while this runs, the masks are obtained again with the next draw call.
+		commandListData.groupMembershipGeneration = groupMembershipGeneration;
+		forEachShaderStage(commandListData.activeStageMask, [&](ShaderStage stage)
+		{
+			const size_t stageIndex = static_cast<size_t>(stage);
+			commandListData.activeShaderPerStage[stageIndex] = deviceData.pipelineRegistry.getPipelineShader(commandListData.activePipelinePerStage[stageIndex], stage);
+		});
+		updateCommandListGroupMask(commandListData);
+	}
+	bool blockCall = false;
 	{
-		blockCall |= group.isBlockedComputeShader(shaderHash);
+		// the groups are edited on another thread, the published configuration is an immutable copy which is safe to read.
+		const GroupConfigurationSnapshot::ReadGuard guard;
+		blockCall = guard.get().isBlockedDrawCall(commandListData.groupMask, commandListData.activeStageMask, commandListData.activeShaderPerStage);
 	}
+	// the shader managers test the hash as that's what's being hunted.
+	forEachShaderStage(commandListData.activeStageMask, [&](ShaderStage stage)
+	{
+		blockCall |= deviceData.getShaderManager(stage).isBlockedShader(commandListData.activeShaderPerStage[static_cast<size_t>(stage)].shaderHash);
+	});
+	commandListData.isDrawCallBlocked = blockCall;
+	commandListData.blockDecisionGeneration = configurationGeneration;
 	return blockCall;
 }
 
 
 static bool onDraw(command_list* commandList, uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance)
 {
+	if(!isDrawCallTrackingEnabled())
+	{
+		countSkippedCallback();
+		return false;
+	}
 	// check if for this command list the active shader handles are part of the blocked set. If so, return true
 	return blockDrawCallForCommandList(commandList);
 }
@@ -396,6 +963,11 @@ static bool onDraw(command_list* commandList, uint32_t vertex_count, uint32_t in
 
 static bool onDrawIndexed(command_list* commandList, uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance)
 {
+	if(!isDrawCallTrackingEnabled())
+	{
+		countSkippedCallback();
+		return false;
+	}
 	// same as onDraw
 	return blockDrawCallForCommandList(commandList);
 }
@@ -403,6 +975,11 @@ static bool onDrawIndexed(command_list* commandList, uint32_t index_count, uint3
 
 static bool onDrawOrDispatchIndirect(command_list* commandList, indirect_command type, resource buffer, uint64_t offset, uint32_t draw_count, uint32_t stride)
 {
+	if(!isDrawCallTrackingEnabled())
+	{
+		countSkippedCallback();
+		return false;
+	}
 	switch(type)
 	{
 		case indirect_command::unknown:
@@ -417,24 +994,79 @@ static bool onDrawOrDispatchIndirect(command_list* commandList, indirect_command
 }
 
 
+/// <summary>
+/// Returns true if draw calls have to be checked, which is the case when a group is active or shaders are being collected or hunted.
+/// </summary>
+static bool isDrawCallTrackingRequired()
+{
+	if(g_toggleGroupIdShaderEditing >= 0 || g_activeCollectorFrameCounter > 0 || isAnyShaderManagerInHuntingMode())
+	{
+		return true;
+	}
+	for(auto& group : g_toggleGroups)
+	{
+		if(group.isActive())
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
+/// <summary>
+/// Enables draw call tracking if draw calls have to be checked and disables it if not. The bind and draw events stay registered, as registering
+/// them isn't safe while render threads dispatch events; the callbacks test the flag instead. Only call this on the present/overlay thread.
+/// </summary>
+static void updateDrawCallTracking()
+{
+	const bool isTrackingRequired = isDrawCallTrackingRequired();
+	if(isTrackingRequired == g_isDrawCallTrackingEnabled.load(std::memory_order_relaxed))
+	{
+		return;
+	}
+	if(isTrackingRequired)
+	{
+		// the command lists have skipped binds while idle, a new epoch makes them discard their state at the next bind.
+		++g_trackingEpoch;
+	}
+	g_isDrawCallTrackingEnabled.store(isTrackingRequired, std::memory_order_relaxed);
+}
+
+
 static void onReshadePresent(effect_runtime* runtime)
 {
+	std::unique_lock groupsLock(g_toggleGroupsMutex);
+	// keeps the statistics current, and the next binds from having to flush.
+	if(g_pipelineRegistrationStaging.hasStagedShaders())
+	{
+		g_pipelineRegistrationStaging.flush();
+	}
+
 	if(g_activeCollectorFrameCounter>0)
 	{
 		--g_activeCollectorFrameCounter;
 	}
+	// the statistics are only shown in the overlay while editing a group, so they're only collected then, unless enabled in the settings.
+	if(ShaderIdPrefilter::setCollectingStatistics(g_statisticsCollectionEnabled || g_toggleGroupIdShaderEditing >= 0))
+	{
+		g_skippedCallbackCount.store(0, std::memory_order_relaxed);
+	}
 
 	for(auto& group: g_toggleGroups)
 	{
 		if(group.isToggleKeyPressed(runtime))
 		{
 			group.toggleActive();
+			markGroupConfigurationChanged();
 			// if the group's shaders are being edited, it should toggle the ones currently marked.
-			if(group.getId() == g_toggleGroupIdShaderEditing)
+			DeviceDataContainer* shaderEditingDevice = g_shaderEditingDevice;
+			if(group.getId() == g_toggleGroupIdShaderEditing && nullptr != shaderEditingDevice)
 			{
-				g_vertexShaderManager.toggleHideMarkedShaders();
-				g_pixelShaderManager.toggleHideMarkedShaders();
-				g_computeShaderManager.toggleHideMarkedShaders();
+				for(auto& shaderManager : shaderEditingDevice->shaderManagers)
+				{
+					shaderManager.toggleHideMarkedShaders();
+				}
 			}
 		}
 	}
@@ -447,45 +1079,40 @@ static void onReshadePresent(effect_runtime* runtime)
 	// Numpad 4: previous vertex shader
 	// Numpad 5: next vertex shader
 	// Numpad 6: mark current vertex shader as part of the toggle group
-	// Numpad 7: previous compute shader
-	// Numpad 8: next compute shader
-	// Numpad 9: mark current compute shader as part of the toggle group
-	if(runtime->is_key_pressed(VK_NUMPAD1))
-	{
-		g_pixelShaderManager.huntPreviousShader(runtime->is_key_down(VK_CONTROL));
-	}
-	if(runtime->is_key_pressed(VK_NUMPAD2))
+	// Numpad 7: previous compute (or geometry, hull, domain) shader
+	// Numpad 8: next compute (or geometry, hull, domain) shader
+	// Numpad 9: mark current compute (or geometry, hull, domain) shader as part of the toggle group
+	// Numpad 0: switch the stage hunted with numpad 7-9
+	const int huntingKeys[3][3] = { { VK_NUMPAD1, VK_NUMPAD2, VK_NUMPAD3 }, { VK_NUMPAD4, VK_NUMPAD5, VK_NUMPAD6 }, { VK_NUMPAD7, VK_NUMPAD8, VK_NUMPAD9 } };
+	const ShaderStage huntingKeyStages[3] = { ShaderStage::Pixel, ShaderStage::Vertex, getHuntedExtraShaderStage() };
+	DeviceDataContainer* shaderEditingDevice = g_shaderEditingDevice;
+	for(size_t i = 0; i < 3; ++i)
 	{
-		g_pixelShaderManager.huntNextShader(runtime->is_key_down(VK_CONTROL));
-	}
-	if(runtime->is_key_pressed(VK_NUMPAD3))
-	{
-		g_pixelShaderManager.toggleMarkOnHuntedShader();
-	}
-	if(runtime->is_key_pressed(VK_NUMPAD4))
-	{
-		g_vertexShaderManager.huntPreviousShader(runtime->is_key_down(VK_CONTROL));
-	}
-	if(runtime->is_key_pressed(VK_NUMPAD5))
-	{
-		g_vertexShaderManager.huntNextShader(runtime->is_key_down(VK_CONTROL));
-	}
-	if(runtime->is_key_pressed(VK_NUMPAD6))
-	{
-		g_vertexShaderManager.toggleMarkOnHuntedShader();
-	}
-	if(runtime->is_key_pressed(VK_NUMPAD7))
-	{
-		g_computeShaderManager.huntPreviousShader(runtime->is_key_down(VK_CONTROL));
-	}
-	if(runtime->is_key_pressed(VK_NUMPAD8))
-	{
-		g_computeShaderManager.huntNextShader(runtime->is_key_down(VK_CONTROL));
+		if(nullptr == shaderEditingDevice)
+		{
+			break;
+		}
+		ShaderManager& shaderManager = shaderEditingDevice->getShaderManager(huntingKeyStages[i]);
+		if(runtime->is_key_pressed(huntingKeys[i][0]))
+		{
+			shaderManager.huntPreviousShader(runtime->is_key_down(VK_CONTROL));
+		}
+		if(runtime->is_key_pressed(huntingKeys[i][1]))
+		{
+			shaderManager.huntNextShader(runtime->is_key_down(VK_CONTROL));
+		}
+		if(runtime->is_key_pressed(huntingKeys[i][2]))
+		{
+			shaderManager.toggleMarkOnHuntedShader();
+		}
 	}
-	if(runtime->is_key_pressed(VK_NUMPAD9))
+	if(runtime->is_key_pressed(VK_NUMPAD0))
 	{
-		g_computeShaderManager.toggleMarkOnHuntedShader();
+		g_huntedExtraShaderStageIndex = (g_huntedExtraShaderStageIndex + 1) % std::size(HUNTABLE_EXTRA_SHADER_STAGES);
 	}
+
+	publishGroupConfiguration();
+	updateDrawCallTracking();
 }
 
 
@@ -530,22 +1157,29 @@ void startKeyBindingEditing(ToggleGroup& groupEditing)
 /// <param name="groupEditing"></param>
 void endShaderEditing(bool acceptCollectedShaderHashes, ToggleGroup& groupEditing)
 {
-	if(acceptCollectedShaderHashes && g_toggleGroupIdShaderEditing == groupEditing.getId())
+	DeviceDataContainer* shaderEditingDevice = g_shaderEditingDevice;
+	if(acceptCollectedShaderHashes && g_toggleGroupIdShaderEditing == groupEditing.getId() && nullptr != shaderEditingDevice)
 	{
-		groupEditing.storeCollectedHashes(g_pixelShaderManager.getMarkedShaderHashes(), g_vertexShaderManager.getMarkedShaderHashes(), g_computeShaderManager.getMarkedShaderHashes());
-		g_pixelShaderManager.stopHuntingMode();
-		g_vertexShaderManager.stopHuntingMode();
-		g_computeShaderManager.stopHuntingMode();
+		const size_t slot = getGroupSlot(groupEditing);
+		for(auto& shaderManager : shaderEditingDevice->shaderManagers)
+		{
+			updateGroupMembershipIndex(slot, shaderManager.getStage(), false);
+			groupEditing.storeCollectedHashes(shaderManager.getStage(), shaderManager.getMarkedShaderHashes());
+			updateGroupMembershipIndex(slot, shaderManager.getStage(), true);
+			shaderManager.stopHuntingMode();
+		}
+		markGroupMembershipChanged();
 	}
 	g_toggleGroupIdShaderEditing = -1;
 }
 
 
 /// <summary>
-/// Function which marks the start of a shader editing cycle for a given toggle group.
+/// Function which marks the start of a shader editing cycle for a given toggle group. The shaders are collected and hunted on the device specified.
 /// </summary>
 /// <param name="groupEditing"></param>
-void startShaderEditing(ToggleGroup& groupEditing)
+/// <param name="deviceData"></param>
+void startShaderEditing(ToggleGroup& groupEditing, DeviceDataContainer& deviceData)
 {
 	if(g_toggleGroupIdShaderEditing==groupEditing.getId())
 	{
@@ -555,14 +1189,32 @@ void startShaderEditing(ToggleGroup& groupEditing)
 	{
 		endShaderEditing(false, groupEditing);
 	}
+	DeviceDataContainer* previousShaderEditingDevice = g_shaderEditingDevice.exchange(&deviceData);
+	if(nullptr != previousShaderEditingDevice && previousShaderEditingDevice != &deviceData)
+	{
+		// the previous device otherwise keeps hiding the shader hunted last.
+		for(auto& shaderManager : previousShaderEditingDevice->shaderManagers)
+		{
+			shaderManager.stopHuntingMode();
+		}
+	}
 	g_toggleGroupIdShaderEditing = groupEditing.getId();
 	g_activeCollectorFrameCounter = g_startValueFramecountCollectionPhase;
-	g_pixelShaderManager.startHuntingMode(groupEditing.getPixelShaderHashes());
-	g_vertexShaderManager.startHuntingMode(groupEditing.getVertexShaderHashes());
-	g_computeShaderManager.startHuntingMode(groupEditing.getComputeShaderHashes());
+	for(auto& shaderManager : deviceData.shaderManagers)
+	{
+		shaderManager.startHuntingMode(groupEditing.getShaderHashes(shaderManager.getStage()));
+	}
+	// start collecting right away, instead of at the next present.
+	updateDrawCallTracking();
 
 	// after copying them to the managers, we can now clear the group's shader.
+	const size_t slot = getGroupSlot(groupEditing);
+	for(size_t stageIndex = 0; stageIndex < SHADER_STAGE_COUNT; ++stageIndex)
+	{
+		updateGroupMembershipIndex(slot, static_cast<ShaderStage>(stageIndex), false);
+	}
 	groupEditing.clearHashes();
+	markGroupMembershipChanged();
 }
 
 
@@ -582,6 +1234,7 @@ static void showHelpMarker(const char* desc)
 
 static void displaySettings(reshade::api::effect_runtime* runtime)
 {
+	std::unique_lock groupsLock(g_toggleGroupsMutex);
 	if(g_toggleGroupIdKeyBindingEditing >= 0)
 	{
 		// a keybinding is being edited. Read current pressed keys into the collector, cumulatively;
@@ -591,7 +1244,7 @@ static void displaySettings(reshade::api::effect_runtime* runtime)
 	if(ImGui::CollapsingHeader("General info and help"))
 	{
 		ImGui::PushTextWrapPos();
-		ImGui::TextUnformatted("The Shader Toggler allows you to create one or more groups with shaders to toggle on/off. You can assign a keyboard shortcut (including using keys like Shift, Alt and Control) to each group, including a handy name. Each group can have one or more vertex or pixel shaders assigned to it. When you press the assigned keyboard shortcut, any draw calls using these shaders will be disabled, effectively hiding the elements in the 3D scene.");
+		ImGui::TextUnformatted("The Shader Toggler allows you to create one or more groups with shaders to toggle on/off. You can assign a keyboard shortcut (including using keys like Shift, Alt and Control) to each group, including a handy name. Each group can have one or more pixel, vertex, compute, geometry, hull or domain shaders assigned to it. When you press the assigned keyboard shortcut, any draw calls using these shaders will be disabled, effectively hiding the elements in the 3D scene.");
 		ImGui::TextUnformatted("\nThe following (hardcoded) keyboard shortcuts are used when you click a group's 'Change Shaders' button:");
 		ImGui::TextUnformatted("* Numpad 1 and Numpad 2: previous/next pixel shader");
 		ImGui::TextUnformatted("* Ctrl + Numpad 1 and Ctrl + Numpad 2: previous/next marked pixel shader in the group");
@@ -602,6 +1255,7 @@ static void displaySettings(reshade::api::effect_runtime* runtime)
 		ImGui::TextUnformatted("* Numpad 7 and Numpad 8: previous/next compute shader");
 		ImGui::TextUnformatted("* Ctrl + Numpad 7 and Ctrl + Numpad 8: previous/next marked compute shader in the group");
 		ImGui::TextUnformatted("* Numpad 9: mark/unmark the current compute shader as being part of the group");
+		ImGui::TextUnformatted("* Numpad 0: switch Numpad 7-9 between the compute, geometry, hull and domain shaders");
 		ImGui::TextUnformatted("\nWhen you step through the shaders, the current shader is disabled in the 3D scene so you can see if that's the shader you were looking for.");
 		ImGui::TextUnformatted("When you're done, make sure you click 'Save all toggle groups' to preserve the groups you defined so next time you start your game they're loaded in and you can use them right away.");
 		ImGui::PopTextWrapPos();
@@ -617,6 +1271,19 @@ static void displaySettings(reshade::api::effect_runtime* runtime)
 		ImGui::SliderInt("# of frames to collect", &g_startValueFramecountCollectionPhase, 10, 1000);
 		ImGui::SameLine();
 		showHelpMarker("This is the number of frames the addon will collect active shaders. Set this to a high number if the shader you want to mark is only used occasionally. Only shaders that are used in the frames collected can be marked.");
+		bool asyncShaderHashingEnabled = g_asyncShaderHashingEnabled;
+		ImGui::Checkbox("Hash shaders in the background", &asyncShaderHashingEnabled);
+		g_asyncShaderHashingEnabled = asyncShaderHashingEnabled;
+		ImGui::SameLine();
+		showHelpMarker("If checked, shaders of newly created pipelines are hashed on background threads, which can reduce stutter when the game creates a lot of pipelines. Until a pipeline's shaders have been hashed, the pipeline isn't blocked by any toggle group. This setting is saved when you click 'Save all Toggle Groups'.");
+		bool fingerprintsEnabled = g_shaderHashCache.areFingerprintsEnabled();
+		ImGui::Checkbox("Calculate 64-bit shader fingerprints", &fingerprintsEnabled);
+		g_shaderHashCache.setFingerprintsEnabled(fingerprintsEnabled);
+		ImGui::SameLine();
+		showHelpMarker("If checked, a 64-bit fingerprint is calculated for every shader next to its hash. It's used to detect different shaders which have the same hash, which are reported in the shader statistics, and it's stored with the shaders of a group when you click 'Save all Toggle Groups'. Only shaders created after enabling this get a fingerprint, so enable it and restart the game for the best results.");
+		ImGui::Checkbox("Collect draw call statistics", &g_statisticsCollectionEnabled);
+		ImGui::SameLine();
+		showHelpMarker("If checked, the draw call statistics shown while you edit a group are also collected while you don't, which costs a little performance. This includes the number of bind and draw calls the addon skipped because no group was active. This setting is saved when you click 'Save all Toggle Groups'.");
 		ImGui::PopItemWidth();
 	}
 	ImGui::Separator();
@@ -668,7 +1335,7 @@ static void displaySettings(reshade::api::effect_runtime* runtime)
 				if(ImGui::Button("Change shaders"))
 				{
 					ImGui::SameLine();
-					startShaderEditing(group);
+					startShaderEditing(group, runtime->get_device()->get_private_data<DeviceDataContainer>());
 				}
 			}
 			ImGui::SameLine();
@@ -752,12 +1419,36 @@ static void displaySettings(reshade::api::effect_runtime* runtime)
 			g_toggleGroupIdKeyBindingEditing = -1;
 			g_keyCollector.clear();
 			g_toggleGroupIdShaderEditing = -1;
-			g_pixelShaderManager.stopHuntingMode();
-			g_vertexShaderManager.stopHuntingMode();
+			DeviceDataContainer* shaderEditingDevice = g_shaderEditingDevice;
+			if(nullptr != shaderEditingDevice)
+			{
+				for(auto& shaderManager : shaderEditingDevice->shaderManagers)
+				{
+					shaderManager.stopHuntingMode();
+				}
+			}
 		}
 		for(const auto& group : toRemove)
 		{
+			const size_t slot = getGroupSlot(group);
+			{
+				std::unique_lock lock(g_devicesMutex);
+				g_groupMembershipIndex.removeSlot(slot);
+			}
 			std::erase(g_toggleGroups, group);
+			if(slot < GROUP_MASK_SLOT_COUNT && g_toggleGroups.size() >= GROUP_MASK_SLOT_COUNT)
+			{
+				// the first group without a slot moved into the last slot.
+				for(size_t stageIndex = 0; stageIndex < SHADER_STAGE_COUNT; ++stageIndex)
+				{
+					updateGroupMembershipIndex(GROUP_MASK_SLOT_COUNT - 1, static_cast<ShaderStage>(stageIndex), true);
+				}
+			}
+		}
+		if(toRemove.size() > 0)
+		{
+			// the groups after the removed ones moved to another slot.
+			markGroupMembershipChanged();
 		}
 
 		ImGui::Separator();
@@ -772,6 +1463,65 @@ static void displaySettings(reshade::api::effect_runtime* runtime)
 }
 
 
+static void onInitDevice(device* device)
+{
+	DeviceDataContainer& deviceData = device->create_private_data<DeviceDataContainer>();
+	std::unique_lock lock(g_devicesMutex);
+	// the new device starts with the current groups and the fingerprints stored with them.
+	for(size_t stageIndex = 0; stageIndex < SHADER_STAGE_COUNT; ++stageIndex)
+	{
+		deviceData.pipelineRegistry.setShaderGroupMasks(static_cast<ShaderStage>(stageIndex), g_groupMembershipIndex.getGroupMasks(static_cast<ShaderStage>(stageIndex)));
+		for(const auto& [shaderHash, fingerprint] : g_knownFingerprintsPerStage[stageIndex])
+		{
+			deviceData.shaderManagers[stageIndex].addKnownFingerprint(shaderHash, fingerprint);
+		}
+	}
+	g_devices.push_back(&deviceData);
+}
+
+
+static void onDestroyDevice(device* device)
+{
+	DeviceDataContainer* deviceData = &device->get_private_data<DeviceDataContainer>();
+	// the hashing workers keep pointers to the device's shader managers.
+	g_asyncShaderHasher.cancelDevice(deviceData);
+	// registrations for the managers of this device could still be staged.
+	if(g_pipelineRegistrationStaging.hasStagedShaders())
+	{
+		g_pipelineRegistrationStaging.flush();
+	}
+	bool isLastDevice = false;
+	{
+		std::unique_lock lock(g_devicesMutex);
+		std::erase(g_devices, deviceData);
+		isLastDevice = g_devices.empty();
+	}
+	std::unique_lock groupsLock(g_toggleGroupsMutex);
+	if(g_shaderEditingDevice == deviceData)
+	{
+		// keep what has been marked so far, the device's managers are gone after this.
+		for(auto& group : g_toggleGroups)
+		{
+			if(group.getId() == g_toggleGroupIdShaderEditing)
+			{
+				endShaderEditing(true, group);
+				break;
+			}
+		}
+		g_toggleGroupIdShaderEditing = -1;
+		g_activeCollectorFrameCounter = 0;
+		g_shaderEditingDevice = nullptr;
+	}
+	groupsLock.unlock();
+	if(isLastDevice)
+	{
+		// joined here rather than in DllMain, where the exiting workers would wait for the loader lock.
+		g_asyncShaderHasher.stopWorkers();
+	}
+	device->destroy_private_data<DeviceDataContainer>();
+}
+
+
 BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID)
 {
 	switch (fdwReason)
@@ -790,6 +1540,8 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID)
 			const std::filesystem::path basePath = dllPath.parent_path();																// <installpath>
 			const std::string& hashFileName = HASH_FILE_NAME;
 			g_iniFileName = (basePath / hashFileName).string();																			// <installpath>/shadertoggler.ini
+			reshade::register_event<reshade::addon_event::init_device>(onInitDevice);
+			reshade::register_event<reshade::addon_event::destroy_device>(onDestroyDevice);
 			reshade::register_event<reshade::addon_event::init_pipeline>(onInitPipeline);
 			reshade::register_event<reshade::addon_event::init_command_list>(onInitCommandList);
 			reshade::register_event<reshade::addon_event::destroy_command_list>(onDestroyCommandList);
@@ -797,6 +1549,7 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID)
 			reshade::register_event<reshade::addon_event::destroy_pipeline>(onDestroyPipeline);
 			reshade::register_event<reshade::addon_event::reshade_overlay>(onReshadeOverlay);
 			reshade::register_event<reshade::addon_event::reshade_present>(onReshadePresent);
+			// registered once. While no group is active, the callbacks return right away.
 			reshade::register_event<reshade::addon_event::bind_pipeline>(onBindPipeline);
 			reshade::register_event<reshade::addon_event::draw>(onDraw);
 			reshade::register_event<reshade::addon_event::draw_indexed>(onDrawIndexed);
@@ -817,7 +1570,11 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD fdwReason, LPVOID)
 		reshade::unregister_event<reshade::addon_event::init_command_list>(onInitCommandList);
 		reshade::unregister_event<reshade::addon_event::destroy_command_list>(onDestroyCommandList);
 		reshade::unregister_event<reshade::addon_event::reset_command_list>(onResetCommandList);
+		reshade::unregister_event<reshade::addon_event::init_device>(onInitDevice);
+		reshade::unregister_event<reshade::addon_event::destroy_device>(onDestroyDevice);
 		reshade::unregister_overlay(nullptr, &displaySettings);
+		// after the events are unregistered, so no work is added anymore. Normally the workers were already stopped with the last device.
+		g_asyncShaderHasher.stop();
 		reshade::unregister_addon(hModule);
 		break;
 	}
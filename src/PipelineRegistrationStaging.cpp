@@ -0,0 +1,175 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+
+#include "PipelineRegistrationStaging.h"
+
+namespace ShaderToggler
+{
+	void PipelineRegistrationStaging::addHashHandlePair(ShaderManager* shaderManager, uint32_t shaderHash, uint64_t pipelineHandle, uint32_t codeSize, uint64_t fingerprint)
+	{
+		if(nullptr == shaderManager || pipelineHandle == 0 || shaderHash == 0)
+		{
+			return;
+		}
+		StagingBuffer& stagingBuffer = getStagingBuffer();
+		std::unique_lock lock(stagingBuffer.mutex);
+		stagingBuffer.stagedShaders.push_back({ shaderManager, { pipelineHandle, shaderHash, codeSize, fingerprint } });
+		stagingBuffer.stagedPipelineHandles.insertOrAssign(pipelineHandle, true);
+		_stagedShaderCount.fetch_add(1, std::memory_order_release);
+		if(stagingBuffer.stagedShaders.size() >= BATCH_SIZE_THRESHOLD)
+		{
+			registerStagedShaders(stagingBuffer);
+		}
+	}
+
+
+	void PipelineRegistrationStaging::flush()
+	{
+		for(StagingBuffer* stagingBuffer = _stagingBuffers.load(); nullptr != stagingBuffer; stagingBuffer = stagingBuffer->next)
+		{
+			std::unique_lock lock(stagingBuffer->mutex);
+			registerStagedShaders(*stagingBuffer);
+		}
+	}
+
+
+	bool PipelineRegistrationStaging::flushCallingThread()
+	{
+		StagingBufferLease& lease = getStagingBufferLease();
+		if(lease.owner != this)
+		{
+			return false;
+		}
+		std::unique_lock lock(lease.stagingBuffer->mutex);
+		if(lease.stagingBuffer->stagedShaders.empty())
+		{
+			return false;
+		}
+		registerStagedShaders(*lease.stagingBuffer);
+		return true;
+	}
+
+
+	bool PipelineRegistrationStaging::isStagedPipeline(uint64_t pipelineHandle)
+	{
+		if(!hasStagedShaders())
+		{
+			return false;
+		}
+		for(StagingBuffer* stagingBuffer = _stagingBuffers.load(); nullptr != stagingBuffer; stagingBuffer = stagingBuffer->next)
+		{
+			std::unique_lock lock(stagingBuffer->mutex);
+			if(stagingBuffer->stagedPipelineHandles.contains(pipelineHandle))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+
+	PipelineRegistrationStaging::StagingBuffer& PipelineRegistrationStaging::getStagingBuffer()
+	{
+		// leased per thread from the last instance used, which in practice is the only one.
+		StagingBufferLease& lease = getStagingBufferLease();
+		if(lease.owner == this)
+		{
+			return *lease.stagingBuffer;
+		}
+		if(nullptr != lease.stagingBuffer)
+		{
+			lease.stagingBuffer->isInUse.store(false, std::memory_order_release);
+		}
+		StagingBuffer* stagingBuffer = nullptr;
+		// a buffer released by an exited thread is reused.
+		for(StagingBuffer* candidate = _stagingBuffers.load(); nullptr != candidate; candidate = candidate->next)
+		{
+			bool isInUse = false;
+			if(candidate->isInUse.compare_exchange_strong(isInUse, true))
+			{
+				stagingBuffer = candidate;
+				break;
+			}
+		}
+		if(nullptr == stagingBuffer)
+		{
+			stagingBuffer = new StagingBuffer();
+			StagingBuffer* head = _stagingBuffers.load();
+			do
+			{
+				stagingBuffer->next = head;
+			}
+			while(!_stagingBuffers.compare_exchange_weak(head, stagingBuffer));
+		}
+		lease.owner = this;
+		lease.stagingBuffer = stagingBuffer;
+		return *stagingBuffer;
+	}
+
+
+	PipelineRegistrationStaging::StagingBufferLease& PipelineRegistrationStaging::getStagingBufferLease()
+	{
+		thread_local StagingBufferLease lease;
+		return lease;
+	}
+
+
+	void PipelineRegistrationStaging::registerStagedShaders(StagingBuffer& stagingBuffer)
+	{
+		// caller owns the lock of the staging buffer.
+		std::vector<StagedShader>& stagedShaders = stagingBuffer.stagedShaders;
+		if(stagedShaders.empty())
+		{
+			return;
+		}
+		// grouped per shader manager, stable so the registrations of a pipeline keep their order.
+		std::stable_sort(stagedShaders.begin(), stagedShaders.end(), [](const StagedShader& a, const StagedShader& b) { return a.shaderManager < b.shaderManager; });
+		std::vector<ShaderRegistration> registrations;
+		registrations.reserve(stagedShaders.size());
+		for(size_t index = 0; index < stagedShaders.size(); ++index)
+		{
+			registrations.push_back(stagedShaders[index].registration);
+			if(index + 1 == stagedShaders.size() || stagedShaders[index + 1].shaderManager != stagedShaders[index].shaderManager)
+			{
+				stagedShaders[index].shaderManager->addHashHandlePairs(registrations);
+				registrations.clear();
+			}
+		}
+		++_batchCount;
+		_registeredShaderCount += stagedShaders.size();
+		_stagedShaderCount.fetch_sub(static_cast<uint32_t>(stagedShaders.size()), std::memory_order_release);
+		stagedShaders.clear();
+		stagingBuffer.stagedPipelineHandles.clear();
+	}
+}
@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "FlatHandleMap.h"
+#include "ShaderManager.h"
+
+namespace ShaderToggler
+{
+	/// <summary>
+	/// Collects the shaders of created pipelines per thread and registers them with their shader managers in batches, so a burst of pipeline
+	/// creations (e.g. while a game warms its pipeline cache) takes a shard lock once per batch instead of once per shader. A thread's batch is
+	/// registered when it reaches a size threshold. flush() registers all staged shaders of all threads, which has to be done before a pipeline
+	/// which could be staged is removed, and is done at every present. A thread looking up a pipeline only flushes its own staged shaders, a
+	/// pipeline staged by another thread is found after that thread's next batch or the next present.
+	/// </summary>
+	class PipelineRegistrationStaging
+	{
+	public:
+		/// <summary>
+		/// Stages the shader hash for the pipeline handle for registration with the shader manager specified. See ShaderManager::addHashHandlePair.
+		/// </summary>
+		/// <param name="shaderManager"></param>
+		/// <param name="shaderHash"></param>
+		/// <param name="pipelineHandle"></param>
+		/// <param name="codeSize"></param>
+		/// <param name="fingerprint"></param>
+		void addHashHandlePair(ShaderManager* shaderManager, uint32_t shaderHash, uint64_t pipelineHandle, uint32_t codeSize, uint64_t fingerprint);
+		/// <summary>
+		/// Registers the staged shaders of all threads.
+		/// </summary>
+		void flush();
+		/// <summary>
+		/// Registers the staged shaders of the calling thread. Returns true if there were any.
+		/// </summary>
+		/// <returns></returns>
+		bool flushCallingThread();
+		/// <summary>
+		/// Returns true if shaders of the pipeline passed in are staged by any thread. A pipeline is registered before it stops being staged. Handles
+		/// aren't unique across devices, so a pipeline of another device with the same handle also makes this return true.
+		/// </summary>
+		/// <param name="pipelineHandle"></param>
+		/// <returns></returns>
+		bool isStagedPipeline(uint64_t pipelineHandle);
+		bool hasStagedShaders() const { return _stagedShaderCount.load(std::memory_order_acquire) > 0; }
+		uint64_t getBatchCount() const { return _batchCount; }
+		uint64_t getRegisteredShaderCount() const { return _registeredShaderCount; }
+
+	private:
+		struct StagedShader
+		{
+			ShaderManager* shaderManager;
+			ShaderRegistration registration;
+		};
+
+		/// <summary>
+		/// The shaders staged by the thread using the buffer. When that thread exits, the buffer is reused by the next thread which needs one, so
+		/// there are never more buffers than threads staging at the same time. Never freed, so flush() can walk the list of buffers without a lock.
+		/// </summary>
+		struct StagingBuffer
+		{
+			std::atomic_bool isInUse = true;
+			std::mutex mutex;
+			std::vector<StagedShader> stagedShaders;
+			FlatHandleMap<bool> stagedPipelineHandles;		// the pipelines of the staged shaders.
+			StagingBuffer* next = nullptr;
+		};
+
+		/// <summary>
+		/// The staging buffer of a thread. Releases the buffer for reuse when the thread exits. What's still staged in it is registered by the
+		/// next flush() or by the thread reusing it.
+		/// </summary>
+		struct StagingBufferLease
+		{
+			const PipelineRegistrationStaging* owner = nullptr;
+			StagingBuffer* stagingBuffer = nullptr;
+
+			~StagingBufferLease()
+			{
+				if(nullptr != stagingBuffer)
+				{
+					stagingBuffer->isInUse.store(false, std::memory_order_release);
+				}
+			}
+		};
+
+		static constexpr size_t BATCH_SIZE_THRESHOLD = 256;
+
+		StagingBuffer& getStagingBuffer();
+		static StagingBufferLease& getStagingBufferLease();
+		void registerStagedShaders(StagingBuffer& stagingBuffer);
+
+		std::atomic<StagingBuffer*> _stagingBuffers = nullptr;
+		std::atomic_uint32_t _stagedShaderCount = 0;
+		std::atomic_uint64_t _batchCount = 0;
+		std::atomic_uint64_t _registeredShaderCount = 0;
+	};
+}
@@ -0,0 +1,374 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "PipelineRegistry.h"
+#include "ShaderIdRegistry.h"
+
+namespace ShaderToggler
+{
+	std::atomic_uint64_t PipelineRegistry::s_lastRegistryId = 0;
+
+	PipelineRegistry::~PipelineRegistry()
+	{
+		for(auto& chunk : _referenceCountChunks)
+		{
+			delete chunk.load();
+		}
+	}
+
+
+	void PipelineRegistry::addPipelineShader(uint64_t pipelineHandle, ShaderStage stage, uint32_t shaderHash)
+	{
+		if(pipelineHandle == 0 || shaderHash == 0)
+		{
+			return;
+		}
+		const uint32_t shaderId = ShaderIdRegistry::getShaderId(shaderHash);
+		Shard& shard = getShard(pipelineHandle);
+		std::unique_lock lock(shard.mutex);
+		addPipelineShader(shard, pipelineHandle, static_cast<size_t>(stage), shaderId);
+	}
+
+
+	void PipelineRegistry::addPipelineShaders(ShaderStage stage, const std::vector<ShaderRegistration>& registrations)
+	{
+		// per shard the indices of the registrations for it.
+		std::vector<uint32_t> registrationIndicesPerShard[SHARD_COUNT];
+		std::vector<uint32_t> shaderIds(registrations.size(), 0);
+		for(size_t index = 0; index < registrations.size(); ++index)
+		{
+			const ShaderRegistration& registration = registrations[index];
+			if(registration.pipelineHandle == 0 || registration.shaderHash == 0)
+			{
+				continue;
+			}
+			shaderIds[index] = ShaderIdRegistry::getShaderId(registration.shaderHash);
+			registrationIndicesPerShard[getShardIndex(registration.pipelineHandle)].push_back(static_cast<uint32_t>(index));
+		}
+		const size_t stageIndex = static_cast<size_t>(stage);
+		for(size_t shardIndex = 0; shardIndex < SHARD_COUNT; ++shardIndex)
+		{
+			const std::vector<uint32_t>& registrationIndices = registrationIndicesPerShard[shardIndex];
+			if(registrationIndices.empty())
+			{
+				continue;
+			}
+			Shard& shard = _shards[shardIndex];
+			std::unique_lock lock(shard.mutex);
+			// grown once for the whole batch instead of rehashing halfway. The batches of the other stages of the same pipelines add none, so
+			// only the pipelines which aren't known yet are counted.
+			size_t newPipelineCount = 0;
+			for(const uint32_t index : registrationIndices)
+			{
+				if(!shard.pipelines.contains(registrations[index].pipelineHandle))
+				{
+					++newPipelineCount;
+				}
+			}
+			shard.pipelines.reserve(shard.pipelines.size() + newPipelineCount);
+			for(const uint32_t index : registrationIndices)
+			{
+				addPipelineShader(shard, registrations[index].pipelineHandle, stageIndex, shaderIds[index]);
+			}
+		}
+	}
+
+
+	void PipelineRegistry::addPipelineShader(Shard& shard, uint64_t pipelineHandle, size_t stageIndex, uint32_t shaderId)
+	{
+		// caller owns the shard lock.
+		PackedPipelineRecord* pipelineRecord = shard.pipelines.find(pipelineHandle);
+		const bool isNewPipeline = nullptr == pipelineRecord;
+		if(isNewPipeline)
+		{
+			shard.pipelines.insertOrAssign(pipelineHandle, {});
+			pipelineRecord = shard.pipelines.find(pipelineHandle);
+		}
+		const uint32_t currentShaderId = pipelineRecord->shaderIds[stageIndex];
+		if(currentShaderId == shaderId)
+		{
+			return;
+		}
+		if(currentShaderId == 0)
+		{
+			++shard.pipelineCountPerStage[stageIndex];
+		}
+		else
+		{
+			releaseShaderReference(stageIndex, currentShaderId);
+		}
+		if(!isNewPipeline)
+		{
+			// the pipeline could be in a lookup cache.
+			++shard.generation;
+		}
+		pipelineRecord->shaderIds[stageIndex] = shaderId;
+		std::atomic_uint32_t* referenceCount = getReferenceCount(stageIndex, shaderId);
+		if(nullptr != referenceCount)
+		{
+			++(*referenceCount);
+		}
+	}
+
+
+	bool PipelineRegistry::tryGetPipeline(uint64_t pipelineHandle, PipelineRecord& pipelineRecord)
+	{
+		Shard& shard = getShard(pipelineHandle);
+		LookupCache& lookupCache = getLookupCache();
+		// the low bits of handles are usually 0, so the bits above them select the entry.
+		LookupCache::Entry& entry = lookupCache.entries[(pipelineHandle >> 4) & (LookupCache::ENTRY_COUNT - 1)];
+		if(entry.registryId == _registryId && entry.pipelineHandle == pipelineHandle && entry.shardGeneration == shard.generation.load(std::memory_order_acquire))
+		{
+			addLookupToStatistics(lookupCache, true);
+			pipelineRecord = entry.pipelineRecord;
+			return true;
+		}
+		addLookupToStatistics(lookupCache, false);
+		std::shared_lock lock(shard.mutex);
+		const PackedPipelineRecord* found = shard.pipelines.find(pipelineHandle);
+		if(nullptr == found)
+		{
+			return false;
+		}
+		unpackPipelineRecord(*found, pipelineRecord);
+		entry.registryId = _registryId;
+		entry.pipelineHandle = pipelineHandle;
+		entry.shardGeneration = shard.generation.load(std::memory_order_relaxed);
+		entry.pipelineRecord = pipelineRecord;
+		return true;
+	}
+
+
+	void PipelineRegistry::unpackPipelineRecord(const PackedPipelineRecord& packedPipelineRecord, PipelineRecord& pipelineRecord) const
+	{
+		// caller owns the lock of at least one shard, which keeps the group masks from changing.
+		pipelineRecord.stageMask = 0;
+		for(size_t stageIndex = 0; stageIndex < SHADER_STAGE_COUNT; ++stageIndex)
+		{
+			const uint32_t shaderId = packedPipelineRecord.shaderIds[stageIndex];
+			if(shaderId == 0)
+			{
+				pipelineRecord.shaders[stageIndex] = { 0, 0, 0 };
+				continue;
+			}
+			const std::vector<uint64_t>& groupMaskPerShaderId = _groupMaskPerShaderId[stageIndex];
+			const uint64_t groupMask = shaderId < groupMaskPerShaderId.size() ? groupMaskPerShaderId[shaderId] : 0;
+			pipelineRecord.shaders[stageIndex] = { ShaderIdRegistry::getShaderHash(shaderId), shaderId, groupMask };
+			pipelineRecord.stageMask |= 1 << stageIndex;
+		}
+	}
+
+
+	PipelineShader PipelineRegistry::getPipelineShader(uint64_t pipelineHandle, ShaderStage stage)
+	{
+		PipelineRecord pipelineRecord;
+		if(!tryGetPipeline(pipelineHandle, pipelineRecord))
+		{
+			return { 0, 0, 0 };
+		}
+		return pipelineRecord.getShader(stage);
+	}
+
+
+	void PipelineRegistry::getLookupCacheStatistics(uint64_t& lookupCount, uint64_t& hitCount) const
+	{
+		lookupCount = _lookupCount.load(std::memory_order_relaxed);
+		hitCount = _lookupCacheHitCount.load(std::memory_order_relaxed);
+	}
+
+
+	void PipelineRegistry::addLookupToStatistics(LookupCache& lookupCache, bool isHit)
+	{
+		// batched, so the lookups of different threads don't contend on the shared counters.
+		++lookupCache.lookupCount;
+		if(isHit)
+		{
+			++lookupCache.hitCount;
+		}
+		if(lookupCache.lookupCount >= LookupCache::STATISTICS_BATCH_SIZE)
+		{
+			_lookupCount.fetch_add(lookupCache.lookupCount, std::memory_order_relaxed);
+			_lookupCacheHitCount.fetch_add(lookupCache.hitCount, std::memory_order_relaxed);
+			lookupCache.lookupCount = 0;
+			lookupCache.hitCount = 0;
+		}
+	}
+
+
+	PipelineRegistry::LookupCache& PipelineRegistry::getLookupCache()
+	{
+		thread_local LookupCache lookupCache;
+		return lookupCache;
+	}
+
+
+	bool PipelineRegistry::removePipeline(uint64_t pipelineHandle, PipelineRecord& removedPipelineRecord)
+	{
+		Shard& shard = getShard(pipelineHandle);
+		std::unique_lock lock(shard.mutex);
+		const PackedPipelineRecord* found = shard.pipelines.find(pipelineHandle);
+		if(nullptr == found)
+		{
+			return false;
+		}
+		unpackPipelineRecord(*found, removedPipelineRecord);
+		shard.pipelines.erase(pipelineHandle);
+		++shard.generation;
+		for(size_t stageIndex = 0; stageIndex < SHADER_STAGE_COUNT; ++stageIndex)
+		{
+			if(removedPipelineRecord.hasShader(static_cast<ShaderStage>(stageIndex)))
+			{
+				--shard.pipelineCountPerStage[stageIndex];
+				releaseShaderReference(stageIndex, removedPipelineRecord.shaders[stageIndex].shaderId);
+			}
+		}
+		return true;
+	}
+
+
+	uint32_t PipelineRegistry::getShaderReferenceCount(ShaderStage stage, uint32_t shaderHash) const
+	{
+		const uint32_t shaderId = ShaderIdRegistry::findShaderId(shaderHash);
+		const uint32_t chunkIndex = shaderId >> ReferenceCountChunk::SIZE_BITS;
+		if(shaderId == 0 || chunkIndex >= ReferenceCountChunk::MAX_COUNT)
+		{
+			return 0;
+		}
+		const ReferenceCountChunk* chunk = _referenceCountChunks[chunkIndex].load(std::memory_order_acquire);
+		if(nullptr == chunk)
+		{
+			return 0;
+		}
+		return chunk->countPerStage[shaderId & (ReferenceCountChunk::SIZE - 1)][static_cast<size_t>(stage)].load();
+	}
+
+
+	std::atomic_uint32_t* PipelineRegistry::getReferenceCount(size_t stageIndex, uint32_t shaderId)
+	{
+		const uint32_t chunkIndex = shaderId >> ReferenceCountChunk::SIZE_BITS;
+		if(shaderId == 0 || chunkIndex >= ReferenceCountChunk::MAX_COUNT)
+		{
+			return nullptr;
+		}
+		ReferenceCountChunk* chunk = _referenceCountChunks[chunkIndex].load(std::memory_order_acquire);
+		if(nullptr == chunk)
+		{
+			// threads adding to different shards can get here at the same time, only one chunk is kept.
+			ReferenceCountChunk* newChunk = new ReferenceCountChunk();
+			if(_referenceCountChunks[chunkIndex].compare_exchange_strong(chunk, newChunk))
+			{
+				chunk = newChunk;
+			}
+			else
+			{
+				delete newChunk;
+			}
+		}
+		return &chunk->countPerStage[shaderId & (ReferenceCountChunk::SIZE - 1)][stageIndex];
+	}
+
+
+	void PipelineRegistry::releaseShaderReference(size_t stageIndex, uint32_t shaderId)
+	{
+		// caller owns the lock of the shard of the pipeline which referenced the shader.
+		std::atomic_uint32_t* referenceCount = getReferenceCount(stageIndex, shaderId);
+		if(nullptr != referenceCount)
+		{
+			--(*referenceCount);
+		}
+	}
+
+
+	void PipelineRegistry::setShaderGroupMasks(ShaderStage stage, const std::vector<ShaderGroupMask>& shaderGroupMasks)
+	{
+		if(shaderGroupMasks.empty())
+		{
+			return;
+		}
+		// all shards are locked, as resolving a pipeline in any of them reads the group masks.
+		std::unique_lock<std::shared_mutex> locks[SHARD_COUNT];
+		for(size_t shardIndex = 0; shardIndex < SHARD_COUNT; ++shardIndex)
+		{
+			locks[shardIndex] = std::unique_lock(_shards[shardIndex].mutex);
+		}
+		// the group masks are kept per shader, so only the masks of the changed shaders have to be updated, not the pipelines using them.
+		std::vector<uint64_t>& groupMaskPerShaderId = _groupMaskPerShaderId[static_cast<size_t>(stage)];
+		for(const auto& shaderGroupMask : shaderGroupMasks)
+		{
+			if(shaderGroupMask.shaderId >= groupMaskPerShaderId.size())
+			{
+				groupMaskPerShaderId.resize(shaderGroupMask.shaderId + 1, 0);
+			}
+			groupMaskPerShaderId[shaderGroupMask.shaderId] = shaderGroupMask.groupMask;
+		}
+		for(auto& shard : _shards)
+		{
+			++shard.generation;
+		}
+	}
+
+
+	void PipelineRegistry::getMemoryStatistics(uint32_t& pipelineCount, size_t& pipelineByteCount, size_t& shaderByteCount)
+	{
+		pipelineCount = 0;
+		pipelineByteCount = sizeof(_shards);
+		for(auto& shard : _shards)
+		{
+			std::shared_lock lock(shard.mutex);
+			pipelineCount += static_cast<uint32_t>(shard.pipelines.size());
+			pipelineByteCount += shard.pipelines.getMemoryUsage();
+		}
+		shaderByteCount = sizeof(PipelineRegistry) - sizeof(_shards);
+		for(const auto& groupMaskPerShaderId : _groupMaskPerShaderId)
+		{
+			shaderByteCount += groupMaskPerShaderId.capacity() * sizeof(uint64_t);
+		}
+		for(const auto& chunk : _referenceCountChunks)
+		{
+			if(nullptr != chunk.load(std::memory_order_relaxed))
+			{
+				shaderByteCount += sizeof(ReferenceCountChunk);
+			}
+		}
+	}
+
+
+	uint32_t PipelineRegistry::getPipelineCount(ShaderStage stage) const
+	{
+		uint32_t toReturn = 0;
+		for(const auto& shard : _shards)
+		{
+			toReturn += shard.pipelineCountPerStage[static_cast<size_t>(stage)];
+		}
+		return toReturn;
+	}
+}
@@ -0,0 +1,253 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+#include <vector>
+
+#include "FlatHandleMap.h"
+#include "GroupMembershipIndex.h"
+#include "ShaderIdBitset.h"
+#include "ShaderStage.h"
+
+namespace ShaderToggler
+{
+	/// <summary>
+	/// The shader of a given stage in a pipeline: its hash, its dense id (see ShaderIdRegistry) and the mask of the toggle group slots which
+	/// contain the shader (bit n set means the group in slot n contains it). All 0 if the pipeline has no shader for the stage.
+	/// </summary>
+	struct PipelineShader
+	{
+		uint32_t shaderHash;
+		uint32_t shaderId;
+		uint64_t groupMask;
+	};
+
+	/// <summary>
+	/// A shader of a pipeline to register. The size and 64-bit fingerprint of the shader's bytecode are only used by the ShaderManager, to detect
+	/// different shaders with the same hash.
+	/// </summary>
+	struct ShaderRegistration
+	{
+		uint64_t pipelineHandle;
+		uint32_t shaderHash;
+		uint32_t codeSize;
+		uint64_t fingerprint;
+	};
+
+	/// <summary>
+	/// All tracked shaders of a pipeline, as returned by the lookups of the PipelineRegistry. The registry itself stores pipelines packed.
+	/// </summary>
+	struct PipelineRecord
+	{
+		PipelineShader shaders[SHADER_STAGE_COUNT];		// index is the ShaderStage.
+		uint8_t stageMask;								// bit n is set if the pipeline has a shader for ShaderStage n.
+
+		bool hasShader(ShaderStage stage) const { return (stageMask & (1 << static_cast<uint8_t>(stage))) != 0; }
+		const PipelineShader& getShader(ShaderStage stage) const { return shaders[static_cast<size_t>(stage)]; }
+	};
+
+	/// <summary>
+	/// Registry of all known pipelines with their shaders for every tracked stage, so binding, drawing and destroying a pipeline takes a single lookup.
+	/// The pipelines are divided over shards by their handle, each with its own lock, so threads creating and binding different pipelines rarely
+	/// contend on the same lock. Per stage it also keeps the number of live pipelines per shader as an atomic reference count, so the references to
+	/// a shader are obtained without locking the shards.
+	/// Lookups go through a small per-thread cache of recently resolved pipelines first, as command lists bind the same few pipelines over and over.
+	/// A cached record is valid as long as the generation of its shard hasn't changed, which is incremented when a pipeline in the shard is changed
+	/// or removed, and when the group masks change. Adding a pipeline doesn't invalidate the cached records, as it can't be cached yet.
+	/// Games can create 100k+ pipelines, so per pipeline only the dense shader id per stage is stored. Hashes come from the ShaderIdRegistry and
+	/// group masks from a table per shader id, as these are the same for every pipeline with the shader.
+	/// </summary>
+	class PipelineRegistry
+	{
+	public:
+		PipelineRegistry() = default;
+		PipelineRegistry(const PipelineRegistry&) = delete;
+		PipelineRegistry& operator=(const PipelineRegistry&) = delete;
+		~PipelineRegistry();
+
+		/// <summary>
+		/// Registers the shader with the hash passed in as the shader of the stage specified of the pipeline. Adds the pipeline if it's not known yet.
+		/// </summary>
+		/// <param name="pipelineHandle"></param>
+		/// <param name="stage"></param>
+		/// <param name="shaderHash"></param>
+		void addPipelineShader(uint64_t pipelineHandle, ShaderStage stage, uint32_t shaderHash);
+		/// <summary>
+		/// Registers the shaders passed in as the shaders of the stage specified of their pipelines. Each shard is locked once for all of them.
+		/// </summary>
+		/// <param name="stage"></param>
+		/// <param name="registrations"></param>
+		void addPipelineShaders(ShaderStage stage, const std::vector<ShaderRegistration>& registrations);
+		/// <summary>
+		/// Returns true if the pipeline is known, in which case pipelineRecord receives its shaders. Uses the lookup cache of the calling thread.
+		/// </summary>
+		/// <param name="pipelineHandle"></param>
+		/// <param name="pipelineRecord"></param>
+		/// <returns></returns>
+		bool tryGetPipeline(uint64_t pipelineHandle, PipelineRecord& pipelineRecord);
+		/// <summary>
+		/// Returns the shader of the stage specified of the pipeline passed in. All 0 if the pipeline isn't known or has no shader for the stage.
+		/// </summary>
+		/// <param name="pipelineHandle"></param>
+		/// <param name="stage"></param>
+		/// <returns></returns>
+		PipelineShader getPipelineShader(uint64_t pipelineHandle, ShaderStage stage);
+		/// <summary>
+		/// Removes the pipeline passed in. Returns true if it was known, in which case removedPipelineRecord receives the shaders it had.
+		/// </summary>
+		/// <param name="pipelineHandle"></param>
+		/// <param name="removedPipelineRecord"></param>
+		/// <returns></returns>
+		bool removePipeline(uint64_t pipelineHandle, PipelineRecord& removedPipelineRecord);
+		/// <summary>
+		/// Returns the number of known pipelines which have the shader passed in as their shader of the stage specified. Doesn't take a shard lock.
+		/// </summary>
+		/// <param name="stage"></param>
+		/// <param name="shaderHash"></param>
+		/// <returns></returns>
+		uint32_t getShaderReferenceCount(ShaderStage stage, uint32_t shaderHash) const;
+		/// <summary>
+		/// Sets the masks of the toggle group slots containing the shaders passed in, as obtained from the GroupMembershipIndex. The masks of
+		/// other shaders are left as they are.
+		/// </summary>
+		/// <param name="stage"></param>
+		/// <param name="shaderGroupMasks"></param>
+		void setShaderGroupMasks(ShaderStage stage, const std::vector<ShaderGroupMask>& shaderGroupMasks);
+		/// <summary>
+		/// Returns the number of known pipelines with a shader of the stage specified.
+		/// </summary>
+		/// <param name="stage"></param>
+		/// <returns></returns>
+		uint32_t getPipelineCount(ShaderStage stage) const;
+		/// <summary>
+		/// Returns the number of lookups done through the per-thread lookup caches and how many of them were found in the cache. Threads report their
+		/// numbers in batches, so the most recent lookups aren't included yet.
+		/// </summary>
+		/// <param name="lookupCount"></param>
+		/// <param name="hitCount"></param>
+		void getLookupCacheStatistics(uint64_t& lookupCount, uint64_t& hitCount) const;
+		/// <summary>
+		/// Returns the number of known pipelines, the number of bytes allocated by the registry to store them and the number of bytes allocated for
+		/// the tables per shader, the group masks and reference counts, which don't grow with the number of pipelines.
+		/// </summary>
+		/// <param name="pipelineCount"></param>
+		/// <param name="pipelineByteCount"></param>
+		/// <param name="shaderByteCount"></param>
+		void getMemoryStatistics(uint32_t& pipelineCount, size_t& pipelineByteCount, size_t& shaderByteCount);
+
+	private:
+		/// <summary>
+		/// How a pipeline is stored: per stage the dense id of its shader, 0 if it has no shader for the stage.
+		/// </summary>
+		struct PackedPipelineRecord
+		{
+			uint32_t shaderIds[SHADER_STAGE_COUNT];
+		};
+
+		/// <summary>
+		/// Part of the pipelines with its own lock. Aligned to a cache line, so the locks of different shards don't share one.
+		/// </summary>
+		struct alignas(64) Shard
+		{
+			FlatHandleMap<PackedPipelineRecord> pipelines;
+			std::atomic_uint32_t pipelineCountPerStage[SHADER_STAGE_COUNT] = {};
+			std::atomic_uint32_t generation = 1;		// incremented on every change to a pipeline in the shard which could be cached, while the lock is held.
+			std::shared_mutex mutex;
+		};
+
+		/// <summary>
+		/// Direct-mapped cache of the pipelines last resolved by a thread. An entry is valid if its registry id and handle match and the generation
+		/// of the pipeline's shard is still the same. Registries are identified by a unique id rather than their address, as a registry of a
+		/// destroyed device and the one of a new device can have the same address.
+		/// </summary>
+		struct LookupCache
+		{
+			struct Entry
+			{
+				uint64_t registryId = 0;
+				uint64_t pipelineHandle = 0;
+				uint32_t shardGeneration = 0;
+				PipelineRecord pipelineRecord = {};
+			};
+
+			static constexpr size_t ENTRY_COUNT = 64;		// power of 2.
+			static constexpr uint32_t STATISTICS_BATCH_SIZE = 1024;
+
+			Entry entries[ENTRY_COUNT];
+			uint32_t lookupCount = 0;		// not yet added to the statistics of the registry.
+			uint32_t hitCount = 0;
+		};
+
+		/// <summary>
+		/// Per shader id of a range of ids the number of pipelines with that shader, per stage. Allocated when the first id of the range is
+		/// referenced and never moved, so the counts can be read without a lock.
+		/// </summary>
+		struct ReferenceCountChunk
+		{
+			static constexpr uint32_t SIZE_BITS = 12;
+			static constexpr uint32_t SIZE = 1 << SIZE_BITS;
+			static constexpr uint32_t MAX_COUNT = 4096;		// as many ids as the ShaderIdRegistry hands out.
+
+			std::atomic_uint32_t countPerStage[SIZE][SHADER_STAGE_COUNT] = {};
+		};
+
+		static constexpr size_t SHARD_COUNT_BITS = 4;
+		static constexpr size_t SHARD_COUNT = 1 << SHARD_COUNT_BITS;
+
+		Shard& getShard(uint64_t pipelineHandle) { return _shards[getShardIndex(pipelineHandle)]; }
+		size_t getShardIndex(uint64_t pipelineHandle) const
+		{
+			// the top bits of a multiplicative hash, so pointers with aligned low bits are spread over all shards.
+			return (pipelineHandle * 0x9E3779B97F4A7C15ull) >> (64 - SHARD_COUNT_BITS);
+		}
+		void addPipelineShader(Shard& shard, uint64_t pipelineHandle, size_t stageIndex, uint32_t shaderId);
+		void unpackPipelineRecord(const PackedPipelineRecord& packedPipelineRecord, PipelineRecord& pipelineRecord) const;
+		void addLookupToStatistics(LookupCache& lookupCache, bool isHit);
+		static LookupCache& getLookupCache();
+		void releaseShaderReference(size_t stageIndex, uint32_t shaderId);
+		std::atomic_uint32_t* getReferenceCount(size_t stageIndex, uint32_t shaderId);
+
+		Shard _shards[SHARD_COUNT];
+		// per stage, per shader id the mask of the toggle group slots containing the shader. Only as large as the highest id in a group. Only
+		// changed while all shard locks are held.
+		std::vector<uint64_t> _groupMaskPerShaderId[SHADER_STAGE_COUNT];
+		std::atomic<ReferenceCountChunk*> _referenceCountChunks[ReferenceCountChunk::MAX_COUNT] = {};
+		const uint64_t _registryId = ++s_lastRegistryId;
+		static std::atomic_uint64_t s_lastRegistryId;
+		std::atomic_uint64_t _lookupCount = 0;
+		std::atomic_uint64_t _lookupCacheHitCount = 0;
+	};
+}
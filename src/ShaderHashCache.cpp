@@ -0,0 +1,130 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "crc32_hash.hpp"
+#include "fingerprint64_hash.hpp"
+#include "ShaderHashCache.h"
+
+// the amount of bytes at the start and at the end of the bytecode which are used for the partial fingerprint.
+#define FINGERPRINT_BYTE_COUNT 32
+// when the cache grows beyond this amount of entries, it's cleared, to avoid it growing without bounds when the game frees and allocates bytecode a lot.
+#define MAX_CACHE_ENTRY_COUNT 65536
+
+namespace ShaderToggler
+{
+	ShaderHashCache::BytecodeKey ShaderHashCache::createKey(const void* code, size_t codeSize)
+	{
+		return { code, codeSize, calculatePartialFingerprint(static_cast<const uint8_t*>(code), codeSize) };
+	}
+
+
+	ShaderHashCache::ShaderHashes ShaderHashCache::getShaderHashes(const void* code, size_t codeSize)
+	{
+		ShaderHashes toReturn = { 0, 0, 0 };
+		if(nullptr == code || codeSize <= 0)
+		{
+			return toReturn;
+		}
+
+		const BytecodeKey key = createKey(code, codeSize);
+		if(tryGetShaderHashes(key, toReturn))
+		{
+			return toReturn;
+		}
+		// not seen before, or the memory has been reused for other bytecode. Hash it outside the lock.
+		toReturn = calculateShaderHashes(static_cast<const uint8_t*>(code), codeSize);
+		storeShaderHashes(key, toReturn);
+		return toReturn;
+	}
+
+
+	bool ShaderHashCache::tryGetShaderHashes(const BytecodeKey& key, ShaderHashes& hashes)
+	{
+		{
+			std::shared_lock lock(_entriesMutex);
+			const auto it = _entries.find(key.code);
+			if(it != _entries.end() && it->second.codeSize == key.codeSize && it->second.partialFingerprint == key.partialFingerprint &&
+			   (!_fingerprintsEnabled || it->second.hashes.fingerprint != 0))
+			{
+				++_hitCount;
+				hashes = it->second.hashes;
+				return true;
+			}
+		}
+		++_missCount;
+		return false;
+	}
+
+
+	void ShaderHashCache::storeShaderHashes(const BytecodeKey& key, const ShaderHashes& hashes)
+	{
+		std::unique_lock lock(_entriesMutex);
+		if(_entries.size() >= MAX_CACHE_ENTRY_COUNT)
+		{
+			_entries.clear();
+		}
+		_entries[key.code] = { key.codeSize, key.partialFingerprint, hashes };
+	}
+
+
+	ShaderHashCache::ShaderHashes ShaderHashCache::calculateShaderHashes(const uint8_t* code, size_t codeSize) const
+	{
+		const uint64_t fingerprint = _fingerprintsEnabled ? compute_fingerprint64(code, codeSize) : 0;
+		return { compute_crc32(code, codeSize), fingerprint, static_cast<uint32_t>(codeSize) };
+	}
+
+
+	void ShaderHashCache::clear()
+	{
+		std::unique_lock lock(_entriesMutex);
+		_entries.clear();
+	}
+
+
+	uint64_t ShaderHashCache::calculatePartialFingerprint(const uint8_t* code, size_t codeSize)
+	{
+		// FNV-1a over the first and last bytes. For DXBC/DXIL containers the first bytes contain the checksum over the complete bytecode, which makes this
+		// a strong fingerprint for these. For SPIR-V the start is the module header and the end is the last function of the module.
+		const size_t amountToRead = codeSize < FINGERPRINT_BYTE_COUNT ? codeSize : FINGERPRINT_BYTE_COUNT;
+		uint64_t fingerprint = 0xCBF29CE484222325ull ^ codeSize;
+		for(size_t i = 0; i < amountToRead; i++)
+		{
+			fingerprint = (fingerprint ^ code[i]) * 0x100000001B3ull;
+		}
+		const uint8_t* tail = code + codeSize - amountToRead;
+		for(size_t i = 0; i < amountToRead; i++)
+		{
+			fingerprint = (fingerprint ^ tail[i]) * 0x100000001B3ull;
+		}
+		return fingerprint;
+	}
+}
@@ -0,0 +1,119 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace ShaderToggler
+{
+	/// <summary>
+	/// Memo cache for shader hashes. In DX12 and Vulkan the same shader bytecode is often passed to the creation of many pipelines, so instead of
+	/// rehashing the full bytecode every time, the hash is cached per bytecode identity: the pointer to the bytecode, its size and a cheap fingerprint
+	/// over the first and last bytes. If the memory is reused for different bytecode, the size or fingerprint won't match and the bytecode is rehashed.
+	/// Optionally, a 64-bit fingerprint over the complete bytecode is calculated next to the crc32, which is used to detect crc32 collisions.
+	/// </summary>
+	class ShaderHashCache
+	{
+	public:
+		/// <summary>
+		/// Identity of a bytecode blob. Created while the bytecode is still accessible, so it can be used to store a hash calculated later on
+		/// from a copy of the bytecode.
+		/// </summary>
+		struct BytecodeKey
+		{
+			const void* code;
+			size_t codeSize;
+			uint64_t partialFingerprint;		// cheap fingerprint over the first and last bytes of the bytecode
+		};
+
+		/// <summary>
+		/// The hashes calculated over the complete bytecode of a shader.
+		/// </summary>
+		struct ShaderHashes
+		{
+			uint32_t shaderHash;		// crc32 of the bytecode, which is used to identify the shader
+			uint64_t fingerprint;		// 64-bit fingerprint of the bytecode, 0 if fingerprints are disabled
+			uint32_t codeSize;
+		};
+
+		static BytecodeKey createKey(const void* code, size_t codeSize);
+
+		/// <summary>
+		/// Returns the hashes of the bytecode passed in, from the cache if the bytecode was hashed before, otherwise they're calculated and cached.
+		/// </summary>
+		/// <param name="code"></param>
+		/// <param name="codeSize"></param>
+		/// <returns></returns>
+		ShaderHashes getShaderHashes(const void* code, size_t codeSize);
+		/// <summary>
+		/// Returns true and the cached hashes in hashes if the bytecode identified by the passed in key was hashed before. False otherwise.
+		/// </summary>
+		/// <param name="key"></param>
+		/// <param name="hashes"></param>
+		/// <returns></returns>
+		bool tryGetShaderHashes(const BytecodeKey& key, ShaderHashes& hashes);
+		void storeShaderHashes(const BytecodeKey& key, const ShaderHashes& hashes);
+		/// <summary>
+		/// Calculates the hashes over the passed in bytecode. The 64-bit fingerprint is only calculated if fingerprints are enabled.
+		/// </summary>
+		/// <param name="code"></param>
+		/// <param name="codeSize"></param>
+		/// <returns></returns>
+		ShaderHashes calculateShaderHashes(const uint8_t* code, size_t codeSize) const;
+		void clear();
+
+		uint32_t getHitCount() const { return _hitCount; }
+		uint32_t getMissCount() const { return _missCount; }
+		bool areFingerprintsEnabled() const { return _fingerprintsEnabled; }
+		void setFingerprintsEnabled(bool newValue) { _fingerprintsEnabled = newValue; }
+
+	private:
+		struct CacheEntry
+		{
+			size_t codeSize;
+			uint64_t partialFingerprint;
+			ShaderHashes hashes;
+		};
+
+		static uint64_t calculatePartialFingerprint(const uint8_t* code, size_t codeSize);
+
+		std::unordered_map<const void*, CacheEntry> _entries;		// per bytecode pointer the cached hash.
+		std::shared_mutex _entriesMutex;
+		std::atomic_uint32_t _hitCount = 0;
+		std::atomic_uint32_t _missCount = 0;
+		std::atomic_bool _fingerprintsEnabled = false;
+	};
+}
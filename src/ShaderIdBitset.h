@@ -0,0 +1,142 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ShaderToggler
+{
+	/// <summary>
+	/// Set of dense shader ids (see ShaderIdRegistry), stored as one bit per id. Testing if an id is in the set is a single bit test.
+	/// </summary>
+	class ShaderIdBitset
+	{
+	public:
+		void set(uint32_t shaderId)
+		{
+			const size_t wordIndex = shaderId >> 6;
+			if(wordIndex >= _words.size())
+			{
+				_words.resize(wordIndex + 1, 0);
+			}
+			_words[wordIndex] |= 1ull << (shaderId & 63);
+		}
+
+		void reset(uint32_t shaderId)
+		{
+			const size_t wordIndex = shaderId >> 6;
+			if(wordIndex < _words.size())
+			{
+				_words[wordIndex] &= ~(1ull << (shaderId & 63));
+			}
+		}
+
+		bool test(uint32_t shaderId) const
+		{
+			const size_t wordIndex = shaderId >> 6;
+			return wordIndex < _words.size() && (_words[wordIndex] & (1ull << (shaderId & 63))) != 0;
+		}
+
+		void clear() { _words.clear(); }
+
+		bool isEmpty() const
+		{
+			for(const uint64_t word : _words)
+			{
+				if(word != 0)
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		/// <summary>
+		/// Adds all ids of the set passed in to this set.
+		/// </summary>
+		/// <param name="other"></param>
+		void unionWith(const ShaderIdBitset& other)
+		{
+			if(other._words.size() > _words.size())
+			{
+				_words.resize(other._words.size(), 0);
+			}
+			for(size_t wordIndex = 0; wordIndex < other._words.size(); ++wordIndex)
+			{
+				_words[wordIndex] |= other._words[wordIndex];
+			}
+		}
+
+		/// <summary>
+		/// Calls func(shaderId) for every id in the set.
+		/// </summary>
+		/// <param name="func"></param>
+		template<typename TFunc>
+		void forEachId(TFunc func) const
+		{
+			forEachDifferentId(ShaderIdBitset(), func);
+		}
+
+		/// <summary>
+		/// Calls func(shaderId) for every id which is in exactly one of this set and the set passed in.
+		/// </summary>
+		/// <param name="other"></param>
+		/// <param name="func"></param>
+		template<typename TFunc>
+		void forEachDifferentId(const ShaderIdBitset& other, TFunc func) const
+		{
+			const size_t wordCount = _words.size() > other._words.size() ? _words.size() : other._words.size();
+			for(size_t wordIndex = 0; wordIndex < wordCount; ++wordIndex)
+			{
+				uint64_t difference = (wordIndex < _words.size() ? _words[wordIndex] : 0) ^ (wordIndex < other._words.size() ? other._words[wordIndex] : 0);
+				for(uint32_t bit = 0; difference != 0; ++bit, difference >>= 1)
+				{
+					if((difference & 1) != 0)
+					{
+						func(static_cast<uint32_t>(wordIndex * 64 + bit));
+					}
+				}
+			}
+		}
+
+		bool operator==(const ShaderIdBitset& rhs) const
+		{
+			return _words == rhs._words;
+		}
+
+	private:
+		std::vector<uint64_t> _words;
+	};
+}
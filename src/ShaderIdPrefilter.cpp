@@ -0,0 +1,110 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "ShaderIdPrefilter.h"
+
+namespace ShaderToggler
+{
+	std::atomic_bool ShaderIdPrefilter::s_isCollectingStatistics = false;
+	std::atomic_uint64_t ShaderIdPrefilter::s_probeCount = 0;
+	std::atomic_uint64_t ShaderIdPrefilter::s_rejectedCount = 0;
+	std::atomic_uint64_t ShaderIdPrefilter::s_falsePositiveCount = 0;
+
+	ShaderIdPrefilter::ShaderIdPrefilter(const ShaderIdBitset* shaderIdsPerStage, uint8_t stageMask)
+	{
+		size_t shaderIdCount = 0;
+		forEachShaderStage(stageMask, [&](ShaderStage stage)
+		{
+			shaderIdsPerStage[static_cast<size_t>(stage)].forEachId([&](uint32_t) { ++shaderIdCount; });
+		});
+		size_t wordCount = 1;
+		while(wordCount * 64 < shaderIdCount * BITS_PER_SHADER_ID)
+		{
+			wordCount *= 2;
+		}
+		_words.assign(wordCount, 0);
+		_wordIndexMask = wordCount - 1;
+		forEachShaderStage(stageMask, [&](ShaderStage stage)
+		{
+			shaderIdsPerStage[static_cast<size_t>(stage)].forEachId([&](uint32_t shaderId)
+			{
+				const uint64_t hash = hashShaderId(stage, shaderId);
+				_words[hash & _wordIndexMask] |= getBitsOfHash(hash);
+			});
+		});
+	}
+
+
+	void ShaderIdPrefilter::countProbe(bool isRejected, bool isFalsePositive)
+	{
+		// batched per thread, so the draw calls of different threads don't contend on the shared counters.
+		thread_local uint32_t probeCount = 0;
+		thread_local uint32_t rejectedCount = 0;
+		thread_local uint32_t falsePositiveCount = 0;
+		++probeCount;
+		rejectedCount += isRejected ? 1 : 0;
+		falsePositiveCount += isFalsePositive ? 1 : 0;
+		if(probeCount >= STATISTICS_BATCH_SIZE)
+		{
+			s_probeCount.fetch_add(probeCount, std::memory_order_relaxed);
+			s_rejectedCount.fetch_add(rejectedCount, std::memory_order_relaxed);
+			s_falsePositiveCount.fetch_add(falsePositiveCount, std::memory_order_relaxed);
+			probeCount = 0;
+			rejectedCount = 0;
+			falsePositiveCount = 0;
+		}
+	}
+
+
+	bool ShaderIdPrefilter::setCollectingStatistics(bool isCollecting)
+	{
+		if(!isCollecting || s_isCollectingStatistics.load(std::memory_order_relaxed))
+		{
+			s_isCollectingStatistics.store(isCollecting, std::memory_order_relaxed);
+			return false;
+		}
+		// probes still batched by threads from when the statistics were collected before are added later on, at most a batch per thread.
+		s_probeCount.store(0, std::memory_order_relaxed);
+		s_rejectedCount.store(0, std::memory_order_relaxed);
+		s_falsePositiveCount.store(0, std::memory_order_relaxed);
+		s_isCollectingStatistics.store(true, std::memory_order_relaxed);
+		return true;
+	}
+
+
+	void ShaderIdPrefilter::getStatistics(uint64_t& probeCount, uint64_t& rejectedCount, uint64_t& falsePositiveCount)
+	{
+		probeCount = s_probeCount.load(std::memory_order_relaxed);
+		rejectedCount = s_rejectedCount.load(std::memory_order_relaxed);
+		falsePositiveCount = s_falsePositiveCount.load(std::memory_order_relaxed);
+	}
+}
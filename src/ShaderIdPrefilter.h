@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "ShaderIdBitset.h"
+#include "ShaderStage.h"
+
+namespace ShaderToggler
+{
+	/// <summary>
+	/// Blocked Bloom filter over the shader ids of all stages of a set of groups, built when the group configuration is compiled. All bits of an
+	/// id are in the same 64-bit word, so an id which isn't in the groups is rejected with one memory access in most cases. If it's not rejected,
+	/// the id could still not be in the groups, which is a false positive.
+	/// </summary>
+	class ShaderIdPrefilter
+	{
+	public:
+		ShaderIdPrefilter() = default;
+		/// <summary>
+		/// Builds the filter over the passed in shader ids of the stages specified.
+		/// </summary>
+		/// <param name="shaderIdsPerStage">the shader ids per stage, index is the ShaderStage</param>
+		/// <param name="stageMask">the stages to filter, bit n is ShaderStage n</param>
+		ShaderIdPrefilter(const ShaderIdBitset* shaderIdsPerStage, uint8_t stageMask);
+
+		/// <summary>
+		/// Returns false if the shader id specified of the stage specified isn't in the filtered ids. Returns true if it is, or is a false positive.
+		/// </summary>
+		/// <param name="stage"></param>
+		/// <param name="shaderId"></param>
+		/// <returns></returns>
+		bool mayContain(ShaderStage stage, uint32_t shaderId) const
+		{
+			const uint64_t hash = hashShaderId(stage, shaderId);
+			const uint64_t bits = getBitsOfHash(hash);
+			return (_words[hash & _wordIndexMask] & bits) == bits;
+		}
+
+		/// <summary>
+		/// Adds the outcome of a probe to the statistics, if they're collected. A false positive is a probe which wasn't rejected of an id which
+		/// isn't in the filtered ids.
+		/// </summary>
+		/// <param name="isRejected"></param>
+		/// <param name="isFalsePositive"></param>
+		static void addProbeToStatistics(bool isRejected, bool isFalsePositive)
+		{
+			if(s_isCollectingStatistics.load(std::memory_order_relaxed))
+			{
+				countProbe(isRejected, isFalsePositive);
+			}
+		}
+		/// <summary>
+		/// Switches collecting the statistics on or off. Off by default, so the draw calls don't pay for them when they aren't shown. When switched
+		/// on, the statistics start at zero. Returns true if that's the case, so other statistics collected under the same flag can start over too.
+		/// Only call this from one thread.
+		/// </summary>
+		/// <param name="isCollecting"></param>
+		/// <returns></returns>
+		static bool setCollectingStatistics(bool isCollecting);
+		/// <summary>
+		/// Returns true if the statistics are collected. Other draw call statistics are collected under the same flag.
+		/// </summary>
+		/// <returns></returns>
+		static bool isCollectingStatistics() { return s_isCollectingStatistics.load(std::memory_order_relaxed); }
+		/// <summary>
+		/// Returns the number of probes of all filters, how many of them were rejected and how many were false positives. Threads report their
+		/// numbers in batches, so the most recent probes aren't included yet.
+		/// </summary>
+		/// <param name="probeCount"></param>
+		/// <param name="rejectedCount"></param>
+		/// <param name="falsePositiveCount"></param>
+		static void getStatistics(uint64_t& probeCount, uint64_t& rejectedCount, uint64_t& falsePositiveCount);
+
+	private:
+		static constexpr uint32_t BITS_PER_SHADER_ID = 16;
+		static constexpr uint32_t STATISTICS_BATCH_SIZE = 1024;
+
+		static uint64_t hashShaderId(ShaderStage stage, uint32_t shaderId)
+		{
+			uint64_t hash = (static_cast<uint64_t>(stage) << 32 | shaderId) * 0x9E3779B97F4A7C15ull;
+			hash ^= hash >> 29;
+			hash *= 0xBF58476D1CE4E5B9ull;
+			return hash ^ (hash >> 32);
+		}
+
+		static void countProbe(bool isRejected, bool isFalsePositive);
+
+		// the low bits of the hash select the word, the top 18 bits select 3 bits in it.
+		static uint64_t getBitsOfHash(uint64_t hash) { return (1ull << (hash >> 58)) | (1ull << ((hash >> 52) & 63)) | (1ull << ((hash >> 46) & 63)); }
+
+		std::vector<uint64_t> _words = std::vector<uint64_t>(1, 0);
+		uint64_t _wordIndexMask = 0;			// the number of words is a power of 2.
+
+		static std::atomic_bool s_isCollectingStatistics;
+		static std::atomic_uint64_t s_probeCount;
+		static std::atomic_uint64_t s_rejectedCount;
+		static std::atomic_uint64_t s_falsePositiveCount;
+	};
+}
@@ -0,0 +1,99 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include "ShaderIdRegistry.h"
+
+namespace ShaderToggler
+{
+	std::unordered_map<uint32_t, uint32_t> ShaderIdRegistry::s_hashToId;
+	std::atomic<uint32_t*> ShaderIdRegistry::s_idToHashChunks[MAX_CHUNK_COUNT] = {};
+	std::atomic_uint32_t ShaderIdRegistry::s_idCount = 1;		// id 0 is 'no shader'.
+	std::shared_mutex ShaderIdRegistry::s_registryMutex;
+
+	uint32_t ShaderIdRegistry::getShaderId(uint32_t shaderHash)
+	{
+		if(shaderHash == 0)
+		{
+			return 0;
+		}
+		{
+			std::shared_lock lock(s_registryMutex);
+			const auto it = s_hashToId.find(shaderHash);
+			if(it != s_hashToId.end())
+			{
+				return it->second;
+			}
+		}
+		std::unique_lock lock(s_registryMutex);
+		// could have been added by another thread between the locks.
+		const auto it = s_hashToId.find(shaderHash);
+		if(it != s_hashToId.end())
+		{
+			return it->second;
+		}
+		const uint32_t shaderId = s_idCount.load(std::memory_order_relaxed);
+		const uint32_t chunkIndex = shaderId >> CHUNK_SIZE_BITS;
+		if(chunkIndex >= MAX_CHUNK_COUNT)
+		{
+			return 0;
+		}
+		uint32_t* chunk = s_idToHashChunks[chunkIndex].load(std::memory_order_relaxed);
+		if(nullptr == chunk)
+		{
+			chunk = new uint32_t[CHUNK_SIZE]();
+			s_idToHashChunks[chunkIndex].store(chunk, std::memory_order_release);
+		}
+		chunk[shaderId & (CHUNK_SIZE - 1)] = shaderHash;
+		s_hashToId.emplace(shaderHash, shaderId);
+		// published after the hash is stored, so readers which see the id also see its hash.
+		s_idCount.store(shaderId + 1, std::memory_order_release);
+		return shaderId;
+	}
+
+
+	uint32_t ShaderIdRegistry::findShaderId(uint32_t shaderHash)
+	{
+		std::shared_lock lock(s_registryMutex);
+		const auto it = s_hashToId.find(shaderHash);
+		return it == s_hashToId.end() ? 0 : it->second;
+	}
+
+
+	uint32_t ShaderIdRegistry::getShaderHash(uint32_t shaderId)
+	{
+		if(shaderId == 0 || shaderId >= s_idCount.load(std::memory_order_acquire))
+		{
+			return 0;
+		}
+		return s_idToHashChunks[shaderId >> CHUNK_SIZE_BITS].load(std::memory_order_acquire)[shaderId & (CHUNK_SIZE - 1)];
+	}
+}
@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace ShaderToggler
+{
+	/// <summary>
+	/// Interns shader hashes into dense, sequential shader ids, starting at 1. Id 0 is used for 'no shader' (hash 0). The ids are only valid during
+	/// the current run and are never stored. They're used to index bitsets (see ShaderIdBitset) which replace hash set lookups on hot paths.
+	/// </summary>
+	class ShaderIdRegistry
+	{
+	public:
+		/// <summary>
+		/// Returns the id for the shader hash passed in. If the hash hasn't been seen before, a new id is assigned to it.
+		/// </summary>
+		/// <param name="shaderHash"></param>
+		/// <returns></returns>
+		static uint32_t getShaderId(uint32_t shaderHash);
+		/// <summary>
+		/// Returns the id for the shader hash passed in, 0 if the hash hasn't been seen before. Doesn't assign a new id.
+		/// </summary>
+		/// <param name="shaderHash"></param>
+		/// <returns></returns>
+		static uint32_t findShaderId(uint32_t shaderHash);
+		/// <summary>
+		/// Returns the shader hash for the shader id passed in, 0 if the id isn't known. Doesn't take a lock.
+		/// </summary>
+		/// <param name="shaderId"></param>
+		/// <returns></returns>
+		static uint32_t getShaderHash(uint32_t shaderId);
+
+	private:
+		static constexpr uint32_t CHUNK_SIZE_BITS = 12;
+		static constexpr uint32_t CHUNK_SIZE = 1 << CHUNK_SIZE_BITS;
+		static constexpr uint32_t MAX_CHUNK_COUNT = 4096;		// 16M ids, more than any game has shaders.
+
+		static std::unordered_map<uint32_t, uint32_t> s_hashToId;
+		// the hashes per id, in chunks which are never moved or freed, so they can be read without a lock. Index is the shader id.
+		static std::atomic<uint32_t*> s_idToHashChunks[MAX_CHUNK_COUNT];
+		static std::atomic_uint32_t s_idCount;					// ids below this value have their hash stored.
+		static std::shared_mutex s_registryMutex;
+	};
+}
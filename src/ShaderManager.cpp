@@ -36,33 +36,116 @@ using namespace reshade::api;
 
 namespace ShaderToggler
 {
-	ShaderManager::ShaderManager(): _activeHuntedShaderHash(0)
+	ShaderManager::ShaderManager(ShaderStage stage, PipelineRegistry& pipelineRegistry): _stage(stage), _pipelineRegistry(pipelineRegistry), _activeHuntedShaderHash(0)
 	{
 	}
 
 
-	void ShaderManager::addHashHandlePair(uint32_t shaderHash, uint64_t pipelineHandle)
+	void ShaderManager::addHashHandlePair(uint32_t shaderHash, uint64_t pipelineHandle, uint32_t codeSize, uint64_t fingerprint)
 	{
 		if(pipelineHandle>0 && shaderHash > 0)
 		{
+			_pipelineRegistry.addPipelineShader(pipelineHandle, _stage, shaderHash);
+			{
+				// most pipelines share their shaders with pipelines created earlier, which then only need a shared lock.
+				std::shared_lock lock(_hashHandlesMutex);
+				const auto it = _shaderIdentities.find(shaderHash);
+				if(it != _shaderIdentities.end() && it->second.codeSize == codeSize && it->second.fingerprint == fingerprint && _shaderHashes.count(shaderHash) == 1)
+				{
+					return;
+				}
+			}
 			std::unique_lock lock(_hashHandlesMutex);
-			_handleToShaderHash[pipelineHandle] = shaderHash;
 			_shaderHashes.emplace(shaderHash);
+			registerShaderIdentity(shaderHash, codeSize, fingerprint);
+		}
+	}
+
+
+	void ShaderManager::addHashHandlePairs(const std::vector<ShaderRegistration>& registrations)
+	{
+		_pipelineRegistry.addPipelineShaders(_stage, registrations);
+		std::unique_lock lock(_hashHandlesMutex);
+		for(const auto& registration : registrations)
+		{
+			if(registration.pipelineHandle > 0 && registration.shaderHash > 0)
+			{
+				_shaderHashes.emplace(registration.shaderHash);
+				registerShaderIdentity(registration.shaderHash, registration.codeSize, registration.fingerprint);
+			}
+		}
+	}
+
+
+	void ShaderManager::addKnownFingerprint(uint32_t shaderHash, uint64_t fingerprint)
+	{
+		if(shaderHash > 0 && fingerprint > 0)
+		{
+			std::unique_lock lock(_hashHandlesMutex);
+			registerShaderIdentity(shaderHash, 0, fingerprint);
+		}
+	}
+
+
+	std::unordered_map<uint32_t, uint64_t> ShaderManager::getShaderFingerprints()
+	{
+		std::unordered_map<uint32_t, uint64_t> toReturn;
+		std::shared_lock lock(_hashHandlesMutex);
+		for(const auto& [shaderHash, identity] : _shaderIdentities)
+		{
+			if(identity.fingerprint > 0)
+			{
+				toReturn[shaderHash] = identity.fingerprint;
+			}
+		}
+		return toReturn;
+	}
+
+
+	void ShaderManager::registerShaderIdentity(uint32_t shaderHash, uint32_t codeSize, uint64_t fingerprint)
+	{
+		// caller owns the hash handles lock.
+		const auto it = _shaderIdentities.find(shaderHash);
+		if(it == _shaderIdentities.end())
+		{
+			_shaderIdentities[shaderHash] = { codeSize, fingerprint };
+			return;
+		}
+		ShaderIdentity& identity = it->second;
+		const bool codeSizeDiffers = identity.codeSize > 0 && codeSize > 0 && identity.codeSize != codeSize;
+		const bool fingerprintDiffers = identity.fingerprint > 0 && fingerprint > 0 && identity.fingerprint != fingerprint;
+		if(codeSizeDiffers || fingerprintDiffers)
+		{
+			// different bytecode with the same crc32.
+			_collidingShaderHashes.emplace(shaderHash);
+			_collidingShaderHashCount = _collidingShaderHashes.size();
+			return;
+		}
+		// fill in what wasn't known yet, e.g. for a fingerprint loaded from the ini file.
+		if(identity.codeSize == 0)
+		{
+			identity.codeSize = codeSize;
+		}
+		if(identity.fingerprint == 0)
+		{
+			identity.fingerprint = fingerprint;
 		}
 	}
 
 
-	void ShaderManager::removeHandle(uint64_t handle)
+	void ShaderManager::removeShader(uint32_t shaderHash)
 	{
 		std::unique_lock ulock(_hashHandlesMutex);
-		if(_handleToShaderHash.count(handle)==1)
+		// checked under the lock: a pipeline added concurrently is registered with the pipeline registry before it takes this lock.
+		if(_pipelineRegistry.getShaderReferenceCount(_stage, shaderHash) > 0)
 		{
-			const auto it = _handleToShaderHash.find(handle);
-			const auto shaderHash = it->second;
-			_handleToShaderHash.erase(handle);
+			return;
+		}
+		{
+			std::unique_lock lock(_collectedActiveHandlesMutex);
 			_collectedActiveShaderHashes.erase(shaderHash);
-			_shaderHashes.erase(shaderHash);
 		}
+		_shaderHashes.erase(shaderHash);
 	}
 
 
@@ -74,7 +157,7 @@ namespace ShaderToggler
 			_markedShaderHashes.clear();
 			for(const auto hash : currentMarkedHashes)
 			{
-				_markedShaderHashes.emplace(hash);
+				_markedShaderHashes.insert(hash);
 			}
 		}
 
@@ -86,6 +169,7 @@ namespace ShaderToggler
 			std::unique_lock lock(_collectedActiveHandlesMutex);
 			_collectedActiveShaderHashes.clear();			// clear it so we start with a clean slate
 		}
+		ConfigurationGeneration::increment();
 	}
 
 
@@ -98,6 +182,7 @@ namespace ShaderToggler
 			std::unique_lock lock(_markedShaderHashMutex);
 			_markedShaderHashes.clear();
 		}
+		ConfigurationGeneration::increment();
 	}
 
 
@@ -106,6 +191,7 @@ namespace ShaderToggler
 		if(_activeHuntedShaderIndex<0 || _collectedActiveShaderHashes.size()<=0 || _activeHuntedShaderIndex >= _collectedActiveShaderHashes.size())
 		{
 			_activeHuntedShaderHash = 0;
+			ConfigurationGeneration::increment();
 			return;
 		}
 
@@ -113,6 +199,7 @@ namespace ShaderToggler
 		auto it = _collectedActiveShaderHashes.begin();
 		std::advance(it, _activeHuntedShaderIndex);
 		_activeHuntedShaderHash = *it;
+		ConfigurationGeneration::increment();
 	}
 
 
@@ -128,7 +215,7 @@ namespace ShaderToggler
 		}
 		if(ctrlPressed)
 		{
-			if(_markedShaderHashes.size()==0 || (_markedShaderHashes.size() == 1 && _markedShaderHashes.count(_activeHuntedShaderHash)==1))
+			if(_markedShaderHashes.size()==0 || (_markedShaderHashes.size() == 1 && _markedShaderHashes.contains(_activeHuntedShaderHash)))
 			{
 				// optimization: if the current active shader is part of marked shader hashes and there is
 				// just 1 marked, then we can also stop. We then don't need to do anything so we can return
@@ -150,7 +237,7 @@ namespace ShaderToggler
 					index = 0;
 				}
 				hash = *it;
-				if(_markedShaderHashes.count(hash) == 1)
+				if(_markedShaderHashes.contains(hash))
 				{
 					// found one
 					foundHash = true;
@@ -163,6 +250,7 @@ namespace ShaderToggler
 			{
 				_activeHuntedShaderIndex = index;
 				_activeHuntedShaderHash = hash;
+				ConfigurationGeneration::increment();
 			}
 			// always done
 			return;
@@ -191,7 +279,7 @@ namespace ShaderToggler
 		}
 		if(ctrlPressed)
 		{
-			if(_markedShaderHashes.size() == 0 || (_markedShaderHashes.size() == 1 && _markedShaderHashes.count(_activeHuntedShaderHash) == 1))
+			if(_markedShaderHashes.size() == 0 || (_markedShaderHashes.size() == 1 && _markedShaderHashes.contains(_activeHuntedShaderHash)))
 			{
 				// optimization: if the current active shader is part of marked shader hashes and there is
 				// just 1 marked, then we can also stop. We then don't need to do anything so we can return
@@ -213,7 +301,7 @@ namespace ShaderToggler
 					index = _collectedActiveShaderHashes.size() - 1;
 				}
 				hash = *it;
-				if(_markedShaderHashes.count(hash) == 1)
+				if(_markedShaderHashes.contains(hash))
 				{
 					// found one
 					foundHash = true;
@@ -226,6 +314,7 @@ namespace ShaderToggler
 			{
 				_activeHuntedShaderIndex = index;
 				_activeHuntedShaderHash = hash;
+				ConfigurationGeneration::increment();
 			}
 			// always done
 			return;
@@ -253,18 +342,17 @@ namespace ShaderToggler
 		}
 		if(_hideMarkedShaders)
 		{
-			// check if the shader hash is part of the toggle group
-			toReturn |= _markedShaderHashes.count(shaderHash)==1;
+			// check if the shader hash is part of the toggle group. Locked, as marking a shader can switch the set to another representation.
+			std::shared_lock lock(_markedShaderHashMutex);
+			toReturn |= _markedShaderHashes.contains(shaderHash);
 		}
 
 		return toReturn;
 	}
 
 
-	void ShaderManager::addActivePipelineHandle(uint64_t handle)
+	void ShaderManager::addActiveShader(uint32_t shaderHash)
 	{
-		// get the shader hash bound to this pipeline handle
-		const auto shaderHash = getShaderHash(handle);
 		if(shaderHash>0)
 		{
 			std::unique_lock lock(_collectedActiveHandlesMutex);
@@ -280,7 +368,7 @@ namespace ShaderToggler
 			return;
 		}
 		std::unique_lock lock(_markedShaderHashMutex);
-		if(_markedShaderHashes.count(_activeHuntedShaderHash)==1)
+		if(_markedShaderHashes.contains(_activeHuntedShaderHash))
 		{
 			// remove it
 			_markedShaderHashes.erase(_activeHuntedShaderHash);
@@ -288,17 +376,8 @@ namespace ShaderToggler
 		else
 		{
 			// add it
-			_markedShaderHashes.emplace(_activeHuntedShaderHash);
-		}
-	}
-
-
-	uint32_t ShaderManager::getShaderHash(uint64_t handle)
-	{
-		if(_handleToShaderHash.count(handle)!=1)
-		{
-			return 0;
+			_markedShaderHashes.insert(_activeHuntedShaderHash);
 		}
-		return _handleToShaderHash.at(handle);
+		ConfigurationGeneration::increment();
 	}
 }
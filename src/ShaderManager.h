@@ -32,28 +32,64 @@
 
 #pragma once
 
-#include <map>
+#include <atomic>
 #include <reshade_api_device.hpp>
 #include <reshade_api_pipeline.hpp>
 #include <shared_mutex>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "CDataFile.h"
+#include "ConfigurationGeneration.h"
+#include "PipelineRegistry.h"
+#include "ShaderHashSet.h"
 #include "ToggleGroup.h"
 
 
 namespace ShaderToggler
 {
 	/// <summary>
-	/// Class which manages a set of shaders for a given type (pixel, vertex...)
+	/// Class which manages a set of shaders for a given type (pixel, vertex...). The pipelines using the shaders are kept in the PipelineRegistry
+	/// shared by the managers of all stages.
 	/// </summary>
 	class ShaderManager
 	{
 	public:
-		ShaderManager();
+		ShaderManager(ShaderStage stage, PipelineRegistry& pipelineRegistry);
 
-		void addHashHandlePair(uint32_t shaderHash, uint64_t pipelineHandle);
-		void removeHandle(uint64_t handle);
+		/// <summary>
+		/// Registers the shader hash for the pipeline handle, also with the pipeline registry. The size and 64-bit fingerprint of the shader's bytecode are used to detect
+		/// different shaders with the same hash. Fingerprint is 0 if fingerprints aren't calculated.
+		/// </summary>
+		/// <param name="shaderHash"></param>
+		/// <param name="pipelineHandle"></param>
+		/// <param name="codeSize"></param>
+		/// <param name="fingerprint"></param>
+		void addHashHandlePair(uint32_t shaderHash, uint64_t pipelineHandle, uint32_t codeSize, uint64_t fingerprint);
+		/// <summary>
+		/// Registers the shaders passed in as in addHashHandlePair, as one batch.
+		/// </summary>
+		/// <param name="registrations"></param>
+		void addHashHandlePairs(const std::vector<ShaderRegistration>& registrations);
+		/// <summary>
+		/// Registers the fingerprint of a shader hash which was obtained elsewhere, e.g. from the ini file, so shaders with the same hash but
+		/// another fingerprint are detected as collisions.
+		/// </summary>
+		/// <param name="shaderHash"></param>
+		/// <param name="fingerprint"></param>
+		void addKnownFingerprint(uint32_t shaderHash, uint64_t fingerprint);
+		/// <summary>
+		/// Returns per shader hash the 64-bit fingerprint, for all shader hashes seen of which a fingerprint is known.
+		/// </summary>
+		/// <returns></returns>
+		std::unordered_map<uint32_t, uint64_t> getShaderFingerprints();
+		/// <summary>
+		/// Called when a pipeline with the shader passed in has been removed from the pipeline registry. The shader is only forgotten when no other
+		/// known pipeline uses it anymore, so it stays in the statistics and in an ongoing hunt as long as it's in use.
+		/// </summary>
+		/// <param name="shaderHash"></param>
+		void removeShader(uint32_t shaderHash);
 		/// <summary>
 		/// Switches on the hunting mode for the shader manager. It will copy the passed in hashes to the set of marked hashes. Hunting mode is the mode
 		///	where the user can step through collected active shaders to mark them for assignment to the current edited group.
@@ -82,32 +118,32 @@ namespace ShaderToggler
 		/// <returns></returns>
 		bool isBlockedShader(uint32_t shaderHash);
 		/// <summary>
-		/// Returns the shader hash for the passed in pipeline handle, if found. 0 otherwise.
+		/// Adds the shader hash of a pipeline which was bound during the collection phase to the collected active shaders.
 		/// </summary>
-		/// <param name="handle"></param>
-		/// <returns></returns>
-		uint32_t getShaderHash(uint64_t handle);
-		void addActivePipelineHandle(uint64_t handle);
+		/// <param name="shaderHash"></param>
+		void addActiveShader(uint32_t shaderHash);
 		void toggleMarkOnHuntedShader();
 
-		uint32_t getPipelineCount() {return _handleToShaderHash.size();}
+		uint32_t getPipelineCount() {return _pipelineRegistry.getPipelineCount(_stage);}
+		ShaderStage getStage() const { return _stage; }
 		uint32_t getShaderCount() { return _shaderHashes.size();}
 		uint32_t getAmountShaderHashesCollected() { return _collectedActiveShaderHashes.size(); }
+		uint32_t getCollidingShaderHashCount() { return _collidingShaderHashCount; }
 		bool isInHuntingMode() { return _isInHuntingMode;}
 		uint32_t getActiveHuntedShaderHash() { return _activeHuntedShaderHash;}
 		int getActiveHuntedShaderIndex() { return _activeHuntedShaderIndex; }
-		void toggleHideMarkedShaders() { _hideMarkedShaders=!_hideMarkedShaders;}
+		void toggleHideMarkedShaders() { _hideMarkedShaders=!_hideMarkedShaders; ConfigurationGeneration::increment();}
 
 		bool isHuntedShaderMarked()
 		{
 			std::shared_lock lock(_markedShaderHashMutex);
-			return _markedShaderHashes.count(_activeHuntedShaderHash)==1;
+			return _markedShaderHashes.contains(_activeHuntedShaderHash);
 		}
 
 		std::unordered_set<uint32_t> getMarkedShaderHashes()
 		{
 			std::shared_lock lock(_markedShaderHashMutex);
-			return _markedShaderHashes;
+			return _markedShaderHashes.toUnorderedSet();
 		}
 
 		uint32_t getMarkedShaderCount()
@@ -115,20 +151,28 @@ namespace ShaderToggler
 			std::shared_lock lock(_markedShaderHashMutex);
 			return _markedShaderHashes.size();
 		}
-
-		bool isKnownHandle(uint64_t pipelineHandle)
-		{
-			std::shared_lock lock(_hashHandlesMutex);
-			return _handleToShaderHash.count(pipelineHandle)==1;
-		}
 		
 	private:
+		/// <summary>
+		/// The size and fingerprint of the bytecode first seen with a given shader hash. 0 means unknown.
+		/// </summary>
+		struct ShaderIdentity
+		{
+			uint32_t codeSize;
+			uint64_t fingerprint;
+		};
+
 		void setActiveHuntedShaderHandle();
+		void registerShaderIdentity(uint32_t shaderHash, uint32_t codeSize, uint64_t fingerprint);
 
+		const ShaderStage _stage;
+		PipelineRegistry& _pipelineRegistry;
 		std::unordered_set<uint32_t> _shaderHashes;				// all shader hashes added through init pipeline
-		std::map<uint64_t, uint32_t> _handleToShaderHash;		// pipeline handle per shader hash. Handle is removed when a pipeline is destroyed.
 		std::unordered_set<uint32_t> _collectedActiveShaderHashes;	// shader hashes bound to pipeline handles which were collected during the collection phase after hunting was enabled, which are the pipeline handles active during the last X frames
-		std::unordered_set<uint32_t> _markedShaderHashes;		// the hashes for shaders which are currently marked.
+		ShaderHashSet _markedShaderHashes;						// the hashes for shaders which are currently marked. Tested on every draw call while hunting.
+		std::unordered_map<uint32_t, ShaderIdentity> _shaderIdentities;	// per shader hash the identity of the bytecode first seen with that hash.
+		std::unordered_set<uint32_t> _collidingShaderHashes;	// shader hashes seen with bytecode of different sizes or fingerprints.
+		std::atomic_uint32_t _collidingShaderHashCount = 0;
 
 		bool _isInHuntingMode = false;
 		int _activeHuntedShaderIndex = -1;
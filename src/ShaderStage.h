@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace ShaderToggler
+{
+	/// <summary>
+	/// The shader stages which are tracked. Used as index in per-stage arrays and as bit index in stage masks (bit n set means ShaderStage n).
+	/// </summary>
+	enum class ShaderStage : uint8_t
+	{
+		Pixel = 0,
+		Vertex,
+		Compute,
+		Hull,
+		Domain,
+		Geometry,
+		Count
+	};
+
+	constexpr size_t SHADER_STAGE_COUNT = static_cast<size_t>(ShaderStage::Count);
+
+	/// <summary>
+	/// Returns the name of the stage passed in, in lower case, e.g. "pixel".
+	/// </summary>
+	/// <param name="stage"></param>
+	/// <returns></returns>
+	inline const char* getShaderStageName(ShaderStage stage)
+	{
+		static constexpr const char* names[SHADER_STAGE_COUNT] = { "pixel", "vertex", "compute", "hull", "domain", "geometry" };
+		return names[static_cast<size_t>(stage)];
+	}
+
+	/// <summary>
+	/// Calls func(stage) for every stage of which the bit is set in the stage mask passed in, so only the stages present are visited.
+	/// </summary>
+	/// <param name="stageMask"></param>
+	/// <param name="func"></param>
+	template<typename TFunc>
+	void forEachShaderStage(uint8_t stageMask, TFunc func)
+	{
+		for(unsigned remainingStages = stageMask; remainingStages != 0; remainingStages &= remainingStages - 1)
+		{
+			func(static_cast<ShaderStage>(std::countr_zero(remainingStages)));
+		}
+	}
+}
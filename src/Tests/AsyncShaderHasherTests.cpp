@@ -0,0 +1,116 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "AsyncShaderHasher.h"
+#include "TestFramework.h"
+
+namespace ShaderToggler
+{
+	/// <summary>
+	/// Creates the shaders of a pipeline with one pixel shader whose hash isn't known yet, so it's hashed by a worker.
+	/// </summary>
+	static std::vector<AsyncShaderHasher::PendingShader> createPendingShaders(ShaderManager* shaderManager, uint64_t pipelineHandle)
+	{
+		AsyncShaderHasher::PendingShader toAdd = { shaderManager, {}, std::vector<uint8_t>(2048), { 0, 0, 0 } };
+		for(size_t index = 0; index < toAdd.bytecode.size(); ++index)
+		{
+			toAdd.bytecode[index] = static_cast<uint8_t>(pipelineHandle * 31 + index);
+		}
+		toAdd.key = ShaderHashCache::createKey(toAdd.bytecode.data(), toAdd.bytecode.size());
+		std::vector<AsyncShaderHasher::PendingShader> toReturn;
+		toReturn.push_back(std::move(toAdd));
+		return toReturn;
+	}
+
+
+	void runAsyncShaderHasherTests()
+	{
+		// pipelines are added while the workers are stopped and restarted, like when a device is destroyed while another one creates pipelines,
+		// and finally while the hasher is stopped. Every pipeline which is accepted has to be either registered or reported as discarded.
+		PipelineRegistry pipelineRegistry;
+		ShaderManager pixelShaderManager(ShaderStage::Pixel, pipelineRegistry);
+		ShaderHashCache hashCache;
+		AsyncShaderHasher asyncShaderHasher(hashCache);
+		const void* device = &pipelineRegistry;
+		const uint64_t pipelineCount = 20000;
+		std::vector<uint8_t> isAcceptedPerPipeline(pipelineCount + 1, 0);
+		std::atomic_uint64_t addedPipelineCount = 0;
+		std::thread adder([&]
+		{
+			for(uint64_t pipelineHandle = 1; pipelineHandle <= pipelineCount; ++pipelineHandle)
+			{
+				auto shaders = createPendingShaders(&pixelShaderManager, pipelineHandle);
+				if(asyncShaderHasher.addPipeline(device, pipelineHandle, shaders))
+				{
+					isAcceptedPerPipeline[pipelineHandle] = 1;
+				}
+				else
+				{
+					// rejected work is left to the caller.
+					CHECK(shaders.size() == 1 && shaders[0].bytecode.size() == 2048);
+				}
+				addedPipelineCount = pipelineHandle;
+			}
+		});
+		uint32_t discardedPipelineCount = 0;
+		while(addedPipelineCount < pipelineCount / 2)
+		{
+			discardedPipelineCount += asyncShaderHasher.stopWorkers();
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+		}
+		discardedPipelineCount += asyncShaderHasher.stop();
+		adder.join();
+
+		auto shaders = createPendingShaders(&pixelShaderManager, pipelineCount + 1);
+		CHECK(!asyncShaderHasher.addPipeline(device, pipelineCount + 1, shaders));
+		CHECK(asyncShaderHasher.getPendingPipelineCount() == 0);
+		uint32_t acceptedPipelineCount = 0;
+		uint32_t registeredPipelineCount = 0;
+		for(uint64_t pipelineHandle = 1; pipelineHandle <= pipelineCount; ++pipelineHandle)
+		{
+			PipelineRecord pipelineRecord;
+			const bool isRegistered = pipelineRegistry.tryGetPipeline(pipelineHandle, pipelineRecord);
+			CHECK(!isRegistered || isAcceptedPerPipeline[pipelineHandle] == 1);
+			acceptedPipelineCount += isAcceptedPerPipeline[pipelineHandle];
+			registeredPipelineCount += isRegistered ? 1 : 0;
+		}
+		CHECK(acceptedPipelineCount == registeredPipelineCount + discardedPipelineCount);
+		CHECK(acceptedPipelineCount < pipelineCount);
+		std::printf("Async shader hasher: %u pipelines accepted, %u registered, %u discarded.\n", acceptedPipelineCount, registeredPipelineCount,
+					discardedPipelineCount);
+	}
+}
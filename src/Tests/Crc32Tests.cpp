@@ -0,0 +1,147 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include <random>
+#include <vector>
+
+#include "crc32_hash.hpp"
+#include "TestFramework.h"
+
+namespace ShaderToggler
+{
+	/// <summary>
+	/// The crc32 as calculated one bit at a time, without a table. Independent of the implementations under test, which all have to return
+	/// exactly these values, as the shader hashes in the ini files of users are these values.
+	/// </summary>
+	static uint32_t calculateReferenceCrc32(const uint8_t* data, size_t size)
+	{
+		uint32_t crc = 0xFFFFFFFF;
+		for(size_t index = 0; index < size; ++index)
+		{
+			crc ^= data[index];
+			for(int bit = 0; bit < 8; ++bit)
+			{
+				crc = (crc >> 1) ^ (0xEDB88320 & (0u - (crc & 1)));
+			}
+		}
+		return ~crc;
+	}
+
+
+	static std::vector<uint8_t> createRandomData(size_t size, uint32_t seed)
+	{
+		std::mt19937 random(seed);
+		std::vector<uint8_t> toReturn(size);
+		for(auto& value : toReturn)
+		{
+			value = static_cast<uint8_t>(random());
+		}
+		return toReturn;
+	}
+
+
+	/// <summary>
+	/// Checks all implementations against the reference for the data passed in.
+	/// </summary>
+	static void checkAllImplementations(const uint8_t* data, size_t size)
+	{
+		const uint32_t expected = calculateReferenceCrc32(data, size);
+		CHECK(~update_crc32_bytewise(0xFFFFFFFF, data, size) == expected);
+		CHECK(~update_crc32_slicing16(0xFFFFFFFF, data, size) == expected);
+		if(is_crc32_pclmul_supported())
+		{
+			CHECK(~update_crc32_pclmul(0xFFFFFFFF, data, size) == expected);
+		}
+		CHECK(~update_crc32(0xFFFFFFFF, data, size) == expected);
+		CHECK(compute_crc32(data, size) == expected);
+	}
+
+
+	void runCrc32Tests()
+	{
+		// the check value of the crc32 standard.
+		const char* checkInput = "123456789";
+		CHECK(compute_crc32(reinterpret_cast<const uint8_t*>(checkInput), 9) == 0xCBF43926);
+		CHECK(compute_crc32(nullptr, 0) == 0);
+
+		// random lengths at random alignments, mostly around the block sizes of the implementations.
+		const std::vector<uint8_t> data = createRandomData(512 * 1024, 1);
+		std::mt19937 random(2);
+		for(size_t size = 0; size <= 256; ++size)
+		{
+			checkAllImplementations(data.data() + random() % 64, size);
+		}
+		for(int iteration = 0; iteration < 500; ++iteration)
+		{
+			const size_t size = random() % (iteration < 400 ? 4096 : data.size() - 64);
+			checkAllImplementations(data.data() + random() % 64, size);
+		}
+
+		// an update continues where the previous one stopped, so a crc can be calculated over split data.
+		for(int iteration = 0; iteration < 100; ++iteration)
+		{
+			const size_t size = random() % 65536;
+			const size_t splitOffset = random() % (size + 1);
+			const uint8_t* start = data.data() + random() % 64;
+			const uint32_t expected = calculateReferenceCrc32(start, size);
+			CHECK(~update_crc32(update_crc32(0xFFFFFFFF, start, splitOffset), start + splitOffset, size - splitOffset) == expected);
+			CHECK(combine_crc32(compute_crc32(start, splitOffset), compute_crc32(start + splitOffset, size - splitOffset), size - splitOffset) == expected);
+		}
+
+		// large blobs are hashed in parallel chunks, which are combined.
+		const std::vector<uint8_t> largeData = createRandomData(get_crc32_parallel_threshold() + 4099, 3);
+		const uint32_t expectedLarge = ~update_crc32_bytewise(0xFFFFFFFF, largeData.data() + 3, largeData.size() - 3);
+		CHECK(compute_crc32(largeData.data() + 3, largeData.size() - 3) == expectedLarge);
+		CHECK(compute_crc32_parallel(largeData.data() + 3, largeData.size() - 3) == expectedLarge);
+		CHECK(calculateReferenceCrc32(largeData.data() + 3, largeData.size() - 3) == expectedLarge);
+	}
+
+
+	void runCrc32Benchmark()
+	{
+		// typical sizes of DXBC and SPIR-V shaders, DXIL shaders, and DXIL with embedded debug info. The byte-at-a-time implementation is the one
+		// used before the faster implementations were added.
+		const size_t sizes[] = { 2 * 1024, 48 * 1024, 512 * 1024, 16 * 1024 * 1024 };
+		const std::vector<uint8_t> data = createRandomData(16 * 1024 * 1024, 4);
+		std::printf("crc32 throughput in MB/s (PCLMULQDQ %s):\n", is_crc32_pclmul_supported() ? "supported" : "not supported");
+		std::printf("%10s %10s %10s %10s %10s\n", "size (KB)", "bytewise", "slicing16", "pclmul", "compute");
+		for(const size_t size : sizes)
+		{
+			const uint8_t* start = data.data();
+			const double bytewise = measureThroughput(size, [&] { return update_crc32_bytewise(0xFFFFFFFF, start, size); });
+			const double slicing16 = measureThroughput(size, [&] { return update_crc32_slicing16(0xFFFFFFFF, start, size); });
+			const double pclmul = is_crc32_pclmul_supported() ? measureThroughput(size, [&] { return update_crc32_pclmul(0xFFFFFFFF, start, size); }) : 0.0;
+			const double compute = measureThroughput(size, [&] { return compute_crc32(start, size); });
+			std::printf("%10zu %10.0f %10.0f %10.0f %10.0f\n", size / 1024, bytewise, slicing16, pclmul, compute);
+		}
+	}
+}
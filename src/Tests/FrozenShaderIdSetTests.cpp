@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "FrozenShaderIdSet.h"
+#include "TestFramework.h"
+
+namespace ShaderToggler
+{
+	/// <summary>
+	/// Creates a set of the number of ids specified, spread randomly over the range [1, idRange].
+	/// </summary>
+	static ShaderIdBitset createRandomShaderIds(uint32_t shaderIdCount, uint32_t idRange, std::vector<bool>& isMemberPerShaderId)
+	{
+		std::mt19937 random(11);
+		ShaderIdBitset toReturn;
+		isMemberPerShaderId.assign(idRange + 1, false);
+		for(uint32_t count = 0; count < shaderIdCount;)
+		{
+			const uint32_t shaderId = 1 + random() % idRange;
+			if(!isMemberPerShaderId[shaderId])
+			{
+				isMemberPerShaderId[shaderId] = true;
+				toReturn.set(shaderId);
+				++count;
+			}
+		}
+		return toReturn;
+	}
+
+
+	/// <summary>
+	/// Checks test() for every id up to a bit past the range of the set, and for the ids the bitset would wrap around to.
+	/// </summary>
+	static void checkMembership(const FrozenShaderIdSet& toCheck, const std::vector<bool>& isMemberPerShaderId)
+	{
+		uint32_t failedCount = 0;
+		for(uint32_t shaderId = 0; shaderId < isMemberPerShaderId.size() + 1000; ++shaderId)
+		{
+			const bool isMember = shaderId < isMemberPerShaderId.size() && isMemberPerShaderId[shaderId];
+			failedCount += toCheck.test(shaderId) != isMember ? 1 : 0;
+		}
+		CHECK(failedCount == 0);
+		CHECK(!toCheck.test(0xFFFFFFFF));
+		CHECK(!toCheck.test(0x80000000));
+	}
+
+
+	void runFrozenShaderIdSetTests()
+	{
+		std::vector<bool> isMemberPerShaderId;
+		// dense ids are stored as a bitset, ids below its range included.
+		ShaderIdBitset denseShaderIds;
+		isMemberPerShaderId.assign(5001, false);
+		for(uint32_t shaderId = 1000; shaderId <= 5000; shaderId += 3)
+		{
+			denseShaderIds.set(shaderId);
+			isMemberPerShaderId[shaderId] = true;
+		}
+		const FrozenShaderIdSet denseSet(denseShaderIds);
+		CHECK(!denseSet.isPerfectHash());
+		CHECK(denseSet.size() == 1334);
+		checkMembership(denseSet, isMemberPerShaderId);
+
+		// sparse ids are stored as a perfect hash, from a few ids to as many as a large game has. The free slots mustn't match id 0.
+		const uint32_t sparseShaderIdCounts[] = { 2, 3, 10, 1000, 50000 };
+		for(const uint32_t shaderIdCount : sparseShaderIdCounts)
+		{
+			const FrozenShaderIdSet sparseSet(createRandomShaderIds(shaderIdCount, 4000000, isMemberPerShaderId));
+			CHECK(sparseSet.isPerfectHash());
+			CHECK(sparseSet.size() == shaderIdCount);
+			checkMembership(sparseSet, isMemberPerShaderId);
+		}
+
+		const FrozenShaderIdSet emptySet;
+		CHECK(emptySet.isEmpty());
+		CHECK(!emptySet.test(0));
+		CHECK(!emptySet.test(1));
+	}
+
+
+	void runFrozenShaderIdSetBenchmark()
+	{
+		// the set is built on the present thread when the groups change, so building it mustn't cause a hitch.
+		std::vector<bool> isMemberPerShaderId;
+		const ShaderIdBitset sparseShaderIds = createRandomShaderIds(50000, 4000000, isMemberPerShaderId);
+		const auto start = std::chrono::steady_clock::now();
+		const FrozenShaderIdSet sparseSet(sparseShaderIds);
+		const double buildMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		constexpr uint32_t TESTS_PER_CALL = 1 << 16;
+		const double testsPerSecond = TESTS_PER_CALL * measureCallsPerSecond([&]
+		{
+			uint32_t memberCount = 0;
+			for(uint32_t shaderId = 0; shaderId < TESTS_PER_CALL; ++shaderId)
+			{
+				memberCount += sparseSet.test(shaderId * 61) ? 1 : 0;
+			}
+			return memberCount;
+		});
+		std::printf("Frozen shader id set of 50000 sparse ids: built in %.2f ms, %.1f million tests per second.\n", buildMilliseconds, testsPerSecond / 1e6);
+	}
+}
@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "GroupConfigurationSnapshot.h"
+#include "TestFramework.h"
+
+namespace ShaderToggler
+{
+	/// <summary>
+	/// Compiles the configuration with the number passed in. Its group mask holds the number and its complement, and the pixel shader set only
+	/// contains the id derived from it, so a reader can tell if a configuration it reads is intact.
+	/// </summary>
+	static CompiledGroupConfiguration* compileNumberedConfiguration(uint32_t number)
+	{
+		CompiledGroupConfiguration* toReturn = new CompiledGroupConfiguration();
+		toReturn->activeGroupsMask = (static_cast<uint64_t>(number) << 32) | static_cast<uint32_t>(~number);
+		ShaderIdBitset shaderIdsPerStage[SHADER_STAGE_COUNT];
+		shaderIdsPerStage[static_cast<size_t>(ShaderStage::Pixel)].set(number % 1000 + 1);
+		toReturn->setActiveOverflowShaderIds(shaderIdsPerStage);
+		return toReturn;
+	}
+
+
+	void runGroupConfigurationSnapshotTests()
+	{
+		// reader threads which act like command lists drawing, while the present thread publishes new configurations. Run with ThreadSanitizer or
+		// AddressSanitizer to also catch a configuration which is deleted while it's read.
+		constexpr int READER_COUNT = 4;
+		constexpr uint32_t PUBLISH_COUNT = 20000;
+		GroupConfigurationSnapshot::publish(compileNumberedConfiguration(0));
+		std::atomic_bool isPublishing = true;
+		std::atomic_uint32_t failedReadCount = 0;
+		std::atomic_uint64_t readCount = 0;
+		std::vector<std::thread> readers;
+		for(int readerIndex = 0; readerIndex < READER_COUNT; ++readerIndex)
+		{
+			readers.emplace_back([&]
+			{
+				uint32_t lastNumber = 0;
+				uint64_t threadReadCount = 0;
+				while(isPublishing.load(std::memory_order_relaxed))
+				{
+					const GroupConfigurationSnapshot::ReadGuard guard;
+					const CompiledGroupConfiguration& configuration = guard.get();
+					const uint32_t number = static_cast<uint32_t>(configuration.activeGroupsMask >> 32);
+					PipelineShader shaderPerStage[SHADER_STAGE_COUNT] = {};
+					shaderPerStage[static_cast<size_t>(ShaderStage::Pixel)].shaderId = number % 1000 + 1;
+					const bool isIntact = static_cast<uint32_t>(configuration.activeGroupsMask) == static_cast<uint32_t>(~number) &&
+										  configuration.isBlockedDrawCall(0, 1 << static_cast<uint8_t>(ShaderStage::Pixel), shaderPerStage);
+					shaderPerStage[static_cast<size_t>(ShaderStage::Pixel)].shaderId = (number + 1) % 1000 + 1;
+					const bool isOtherShaderBlocked = configuration.isBlockedDrawCall(0, 1 << static_cast<uint8_t>(ShaderStage::Pixel), shaderPerStage);
+					// configurations are published in order, so a reader never goes back to an older one.
+					if(!isIntact || isOtherShaderBlocked || number < lastNumber)
+					{
+						++failedReadCount;
+					}
+					lastNumber = number;
+					++threadReadCount;
+				}
+				readCount += threadReadCount;
+			});
+		}
+		for(uint32_t number = 1; number <= PUBLISH_COUNT; ++number)
+		{
+			GroupConfigurationSnapshot::publish(compileNumberedConfiguration(number));
+		}
+		isPublishing = false;
+		for(auto& reader : readers)
+		{
+			reader.join();
+		}
+		CHECK(failedReadCount == 0);
+		CHECK(readCount > 0);
+		{
+			const GroupConfigurationSnapshot::ReadGuard guard;
+			CHECK(guard.get().activeGroupsMask >> 32 == PUBLISH_COUNT);
+		}
+		// leaves an empty configuration for the other tests.
+		GroupConfigurationSnapshot::publish(new CompiledGroupConfiguration());
+	}
+
+
+	void runGroupConfigurationSnapshotBenchmark()
+	{
+		// the cost of a draw call reading the configuration, which is what a draw thread pays instead of locking the groups.
+		constexpr uint64_t READS_PER_CALL = 1 << 16;
+		PipelineShader shaderPerStage[SHADER_STAGE_COUNT] = {};
+		const double readsPerSecond = READS_PER_CALL * measureCallsPerSecond([&]
+		{
+			uint32_t blockedCount = 0;
+			for(uint64_t read = 0; read < READS_PER_CALL; ++read)
+			{
+				const GroupConfigurationSnapshot::ReadGuard guard;
+				shaderPerStage[0].shaderId = static_cast<uint32_t>(read);
+				blockedCount += guard.get().isBlockedDrawCall(read, 1, shaderPerStage) ? 1 : 0;
+			}
+			return blockedCount;
+		});
+		std::printf("Group configuration reads: %.1f million per second on one thread.\n", readsPerSecond / 1e6);
+	}
+}
@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include <vector>
+
+#include "crc32_hash.hpp"
+#include "fingerprint64_hash.hpp"
+#include "PipelineRegistry.h"
+#include "ShaderManager.h"
+#include "TestFramework.h"
+
+namespace ShaderToggler
+{
+	void runShaderFingerprintTests()
+	{
+		std::vector<uint8_t> data(1000 + 8);
+		for(size_t index = 0; index < 1000; ++index)
+		{
+			data[index] = static_cast<uint8_t>(index * 31 + 7);
+		}
+		// fingerprints are saved in the ini file, so they have to stay the same. Covers every path of the implementation.
+		struct ExpectedFingerprint
+		{
+			size_t size;
+			uint64_t fingerprint;
+		};
+		const ExpectedFingerprint expectedFingerprints[] =
+		{
+			{ 0, 0x0409638EE2BDE459ull }, { 1, 0x273E27788315D8EFull }, { 3, 0x4AE89FCFFA2248A9ull }, { 4, 0x3F81C3E504696307ull },
+			{ 8, 0x2198922375490193ull }, { 16, 0xF195C204ED7EFF9Bull }, { 17, 0x412D634739BD7335ull }, { 48, 0xE08FF757FAA65C85ull },
+			{ 49, 0x74FF48C76B594158ull }, { 100, 0xE8E55609A6EE2C17ull }, { 1000, 0xA2EF4034C94406D8ull },
+		};
+		for(const auto& expected : expectedFingerprints)
+		{
+			CHECK(compute_fingerprint64(data.data(), expected.size) == expected.fingerprint);
+		}
+
+		// the same at every alignment, and different for every single changed bit.
+		for(size_t size = 1; size <= 200; ++size)
+		{
+			const uint64_t fingerprint = compute_fingerprint64(data.data(), size);
+			std::vector<uint8_t> copy(size + 8);
+			for(size_t offset = 1; offset < 8; ++offset)
+			{
+				std::copy(data.begin(), data.begin() + size, copy.begin() + offset);
+				CHECK(compute_fingerprint64(copy.data() + offset, size) == fingerprint);
+			}
+			for(size_t bit = 0; bit < size * 8; bit += 7)
+			{
+				data[bit / 8] ^= static_cast<uint8_t>(1 << (bit % 8));
+				CHECK(compute_fingerprint64(data.data(), size) != fingerprint);
+				data[bit / 8] ^= static_cast<uint8_t>(1 << (bit % 8));
+			}
+		}
+
+		// bytecode of another size or with another fingerprint with the same crc32 is detected as a collision, the same bytecode isn't.
+		PipelineRegistry pipelineRegistry;
+		ShaderManager shaderManager(ShaderStage::Pixel, pipelineRegistry);
+		shaderManager.addHashHandlePair(0x1234, 0x100, 64, 0xAAAA);
+		shaderManager.addHashHandlePair(0x1234, 0x200, 64, 0xAAAA);
+		CHECK(shaderManager.getCollidingShaderHashCount() == 0);
+		shaderManager.addHashHandlePair(0x1234, 0x300, 128, 0xAAAA);
+		CHECK(shaderManager.getCollidingShaderHashCount() == 1);
+		shaderManager.addKnownFingerprint(0x5678, 0xBBBB);
+		shaderManager.addHashHandlePair(0x5678, 0x400, 64, 0xBBBB);
+		CHECK(shaderManager.getCollidingShaderHashCount() == 1);
+		shaderManager.addHashHandlePairs({ { 0x500, 0x5678, 64, 0xCCCC } });
+		CHECK(shaderManager.getCollidingShaderHashCount() == 2);
+		CHECK(shaderManager.getShaderFingerprints()[0x5678] == 0xBBBB);
+	}
+
+
+	void runShaderFingerprintBenchmark()
+	{
+		// the fingerprint is calculated next to the crc32 of every new shader, so it should add little.
+		const size_t sizes[] = { 2 * 1024, 48 * 1024, 512 * 1024 };
+		std::vector<uint8_t> data(512 * 1024);
+		for(size_t index = 0; index < data.size(); ++index)
+		{
+			data[index] = static_cast<uint8_t>(index * 131 + (index >> 9));
+		}
+		std::printf("fingerprint64 throughput in MB/s:\n");
+		std::printf("%10s %10s %10s\n", "size (KB)", "crc32", "fingerprint");
+		for(const size_t size : sizes)
+		{
+			const double crc32 = measureThroughput(size, [&] { return compute_crc32(data.data(), size); });
+			const double fingerprint = measureThroughput(size, [&] { return compute_fingerprint64(data.data(), size); });
+			std::printf("%10zu %10.0f %10.0f\n", size / 1024, crc32, fingerprint);
+		}
+	}
+}
@@ -0,0 +1,153 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include <random>
+#include <vector>
+
+#include "crc32_hash.hpp"
+#include "fingerprint64_hash.hpp"
+#include "ShaderHashCache.h"
+#include "TestFramework.h"
+
+namespace ShaderToggler
+{
+	/// <summary>
+	/// Creates shader modules with the sizes of typical DXBC/DXIL shaders and the order in which a game creates its pipelines with them: each
+	/// module is used by many pipelines.
+	/// </summary>
+	static void createPipelineLoadSequence(std::vector<std::vector<uint8_t>>& shaderModules, std::vector<uint32_t>& moduleIndexPerPipeline)
+	{
+		std::mt19937 random(5);
+		shaderModules.resize(500);
+		for(auto& shaderModule : shaderModules)
+		{
+			shaderModule.resize(4096 + random() % (60 * 1024));
+			for(auto& value : shaderModule)
+			{
+				value = static_cast<uint8_t>(random());
+			}
+		}
+		moduleIndexPerPipeline.resize(20000);
+		for(auto& moduleIndex : moduleIndexPerPipeline)
+		{
+			moduleIndex = random() % shaderModules.size();
+		}
+	}
+
+
+	void runShaderHashCacheTests()
+	{
+		std::vector<uint8_t> bytecode(3000);
+		for(size_t index = 0; index < bytecode.size(); ++index)
+		{
+			bytecode[index] = static_cast<uint8_t>(index * 7);
+		}
+		ShaderHashCache hashCache;
+		const ShaderHashCache::ShaderHashes hashes = hashCache.getShaderHashes(bytecode.data(), bytecode.size());
+		CHECK(hashes.shaderHash == compute_crc32(bytecode.data(), bytecode.size()));
+		CHECK(hashes.codeSize == bytecode.size());
+		CHECK(hashes.fingerprint == 0);
+		CHECK(hashCache.getMissCount() == 1);
+
+		// the same bytecode again is a hit, with the same hashes.
+		const ShaderHashCache::ShaderHashes cachedHashes = hashCache.getShaderHashes(bytecode.data(), bytecode.size());
+		CHECK(cachedHashes.shaderHash == hashes.shaderHash);
+		CHECK(hashCache.getHitCount() == 1);
+
+		// the memory reused for other bytecode, of the same size and of another size, is hashed again.
+		for(auto& value : bytecode)
+		{
+			value ^= 0x5A;
+		}
+		CHECK(hashCache.getShaderHashes(bytecode.data(), bytecode.size()).shaderHash == compute_crc32(bytecode.data(), bytecode.size()));
+		CHECK(hashCache.getShaderHashes(bytecode.data(), 2000).shaderHash == compute_crc32(bytecode.data(), 2000));
+		CHECK(hashCache.getMissCount() == 3);
+
+		// cached hashes without a fingerprint aren't used once fingerprints are enabled.
+		hashCache.setFingerprintsEnabled(true);
+		const ShaderHashCache::ShaderHashes fingerprintedHashes = hashCache.getShaderHashes(bytecode.data(), 2000);
+		CHECK(fingerprintedHashes.shaderHash == compute_crc32(bytecode.data(), 2000));
+		CHECK(fingerprintedHashes.fingerprint == compute_fingerprint64(bytecode.data(), 2000));
+		CHECK(hashCache.getMissCount() == 4);
+
+		// every pipeline of a load sequence gets the hash of its module.
+		std::vector<std::vector<uint8_t>> shaderModules;
+		std::vector<uint32_t> moduleIndexPerPipeline;
+		createPipelineLoadSequence(shaderModules, moduleIndexPerPipeline);
+		ShaderHashCache loadHashCache;
+		bool areAllHashesCorrect = true;
+		for(const uint32_t moduleIndex : moduleIndexPerPipeline)
+		{
+			const auto& shaderModule = shaderModules[moduleIndex];
+			areAllHashesCorrect &= loadHashCache.getShaderHashes(shaderModule.data(), shaderModule.size()).shaderHash == compute_crc32(shaderModule.data(), shaderModule.size());
+		}
+		CHECK(areAllHashesCorrect);
+		CHECK(loadHashCache.getMissCount() <= shaderModules.size());
+	}
+
+
+	void runShaderHashCacheBenchmark()
+	{
+		// replays the creation of the pipelines of a game, which hashes the bytecode of every pipeline's shader. Before the cache, the complete
+		// bytecode was hashed for every pipeline.
+		std::vector<std::vector<uint8_t>> shaderModules;
+		std::vector<uint32_t> moduleIndexPerPipeline;
+		createPipelineLoadSequence(shaderModules, moduleIndexPerPipeline);
+		size_t byteCount = 0;
+		for(const uint32_t moduleIndex : moduleIndexPerPipeline)
+		{
+			byteCount += shaderModules[moduleIndex].size();
+		}
+		const double uncached = measureThroughput(byteCount, [&]
+		{
+			uint32_t toReturn = 0;
+			for(const uint32_t moduleIndex : moduleIndexPerPipeline)
+			{
+				toReturn ^= compute_crc32(shaderModules[moduleIndex].data(), shaderModules[moduleIndex].size());
+			}
+			return toReturn;
+		});
+		const double cached = measureThroughput(byteCount, [&]
+		{
+			// a new cache per replay, so the first pipeline of every module is a miss, as it is when a game is started.
+			ShaderHashCache hashCache;
+			uint32_t toReturn = 0;
+			for(const uint32_t moduleIndex : moduleIndexPerPipeline)
+			{
+				toReturn ^= hashCache.getShaderHashes(shaderModules[moduleIndex].data(), shaderModules[moduleIndex].size()).shaderHash;
+			}
+			return toReturn;
+		});
+		std::printf("Shader hashes of %zu pipelines using %zu shader modules: %.0f MB/s of bytecode uncached, %.0f MB/s with the cache.\n",
+					moduleIndexPerPipeline.size(), shaderModules.size(), uncached, cached);
+	}
+}
@@ -0,0 +1,159 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include <random>
+#include <vector>
+
+#include "FrozenShaderIdSet.h"
+#include "ShaderIdPrefilter.h"
+#include "TestFramework.h"
+
+namespace ShaderToggler
+{
+	static constexpr uint32_t SHADER_ID_RANGE = 1000000;
+
+	/// <summary>
+	/// Fills the sets of the pixel and vertex stages with random ids, as the overflow groups of a game with many shaders would have.
+	/// </summary>
+	static void createShaderIdsPerStage(ShaderIdBitset* shaderIdsPerStage, std::vector<bool>* isMemberPerStage)
+	{
+		std::mt19937 random(3);
+		const ShaderStage stages[] = { ShaderStage::Pixel, ShaderStage::Vertex };
+		const uint32_t shaderIdCounts[] = { 5000, 3000 };
+		for(size_t index = 0; index < 2; ++index)
+		{
+			const size_t stageIndex = static_cast<size_t>(stages[index]);
+			isMemberPerStage[stageIndex].assign(SHADER_ID_RANGE + 1, false);
+			for(uint32_t count = 0; count < shaderIdCounts[index]; ++count)
+			{
+				const uint32_t shaderId = 1 + random() % SHADER_ID_RANGE;
+				shaderIdsPerStage[stageIndex].set(shaderId);
+				isMemberPerStage[stageIndex][shaderId] = true;
+			}
+		}
+	}
+
+
+	void runShaderIdPrefilterTests()
+	{
+		ShaderIdBitset shaderIdsPerStage[SHADER_STAGE_COUNT];
+		std::vector<bool> isMemberPerStage[SHADER_STAGE_COUNT];
+		createShaderIdsPerStage(shaderIdsPerStage, isMemberPerStage);
+		const uint8_t stageMask = (1u << static_cast<size_t>(ShaderStage::Pixel)) | (1u << static_cast<size_t>(ShaderStage::Vertex));
+		const ShaderIdPrefilter prefilter(shaderIdsPerStage, stageMask);
+
+		// every id in the stages is let through, and with 16 bits per id, 3 of them in one word, about 1% of the other ids is too. The ids of
+		// one stage are other ids for the other stage.
+		const ShaderStage stages[] = { ShaderStage::Pixel, ShaderStage::Vertex };
+		for(const ShaderStage stage : stages)
+		{
+			const std::vector<bool>& isMember = isMemberPerStage[static_cast<size_t>(stage)];
+			uint32_t falseNegativeCount = 0;
+			uint32_t falsePositiveCount = 0;
+			uint32_t otherIdCount = 0;
+			for(uint32_t shaderId = 0; shaderId <= SHADER_ID_RANGE; ++shaderId)
+			{
+				const bool mayContain = prefilter.mayContain(stage, shaderId);
+				if(isMember[shaderId])
+				{
+					falseNegativeCount += mayContain ? 0 : 1;
+				}
+				else
+				{
+					++otherIdCount;
+					falsePositiveCount += mayContain ? 1 : 0;
+				}
+			}
+			CHECK(falseNegativeCount == 0);
+			CHECK(falsePositiveCount * 100 < otherIdCount * 3);
+		}
+
+		// the statistics start at zero every time they're switched on.
+		CHECK(ShaderIdPrefilter::setCollectingStatistics(true));
+		CHECK(!ShaderIdPrefilter::setCollectingStatistics(true));
+		for(int probe = 0; probe < 4096; ++probe)
+		{
+			ShaderIdPrefilter::addProbeToStatistics(probe % 2 == 0, probe % 4 == 1);
+		}
+		uint64_t probeCount = 0;
+		uint64_t rejectedCount = 0;
+		uint64_t falsePositiveCount = 0;
+		ShaderIdPrefilter::getStatistics(probeCount, rejectedCount, falsePositiveCount);
+		CHECK(probeCount == 4096 && rejectedCount == 2048 && falsePositiveCount == 1024);
+		CHECK(!ShaderIdPrefilter::setCollectingStatistics(false));
+		ShaderIdPrefilter::addProbeToStatistics(true, false);
+		CHECK(ShaderIdPrefilter::setCollectingStatistics(true));
+		ShaderIdPrefilter::getStatistics(probeCount, rejectedCount, falsePositiveCount);
+		CHECK(probeCount == 0 && rejectedCount == 0 && falsePositiveCount == 0);
+		ShaderIdPrefilter::setCollectingStatistics(false);
+	}
+
+
+	void runShaderIdPrefilterBenchmark()
+	{
+		// the shaders of most draw calls aren't in the overflow groups. Compares testing them against the perfect hash of a large group with and
+		// without the prefilter in front of it.
+		ShaderIdBitset shaderIdsPerStage[SHADER_STAGE_COUNT];
+		std::vector<bool> isMemberPerStage[SHADER_STAGE_COUNT];
+		createShaderIdsPerStage(shaderIdsPerStage, isMemberPerStage);
+		const FrozenShaderIdSet pixelShaderIds(shaderIdsPerStage[static_cast<size_t>(ShaderStage::Pixel)]);
+		const ShaderIdPrefilter prefilter(shaderIdsPerStage, 1u << static_cast<size_t>(ShaderStage::Pixel));
+		CHECK(pixelShaderIds.isPerfectHash());
+		constexpr uint32_t TESTS_PER_CALL = 1 << 16;
+		std::vector<uint32_t> probedShaderIds(TESTS_PER_CALL);
+		std::mt19937 random(7);
+		for(auto& shaderId : probedShaderIds)
+		{
+			shaderId = 1 + random() % SHADER_ID_RANGE;
+		}
+		const double testsPerSecond = TESTS_PER_CALL * measureCallsPerSecond([&]
+		{
+			uint32_t memberCount = 0;
+			for(const uint32_t shaderId : probedShaderIds)
+			{
+				memberCount += pixelShaderIds.test(shaderId) ? 1 : 0;
+			}
+			return memberCount;
+		});
+		const double prefilteredTestsPerSecond = TESTS_PER_CALL * measureCallsPerSecond([&]
+		{
+			uint32_t memberCount = 0;
+			for(const uint32_t shaderId : probedShaderIds)
+			{
+				memberCount += prefilter.mayContain(ShaderStage::Pixel, shaderId) && pixelShaderIds.test(shaderId) ? 1 : 0;
+			}
+			return memberCount;
+		});
+		std::printf("Overflow group tests of other shaders: %.1f million per second, %.1f million per second with the prefilter.\n",
+					testsPerSecond / 1e6, prefilteredTestsPerSecond / 1e6);
+	}
+}
@@ -0,0 +1,105 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace ShaderToggler
+{
+	/// <summary>
+	/// Reports a failed check of a test. The test runner returns the number of failed checks as its exit code.
+	/// </summary>
+	/// <param name="condition"></param>
+	/// <param name="file"></param>
+	/// <param name="line"></param>
+	void reportFailedCheck(const char* condition, const char* file, int line);
+
+	/// <summary>
+	/// Calls func repeatedly for at least the minimum duration and returns the number of calls per second. func returns a value which is kept,
+	/// so the calls aren't optimized away.
+	/// </summary>
+	/// <param name="func"></param>
+	/// <returns></returns>
+	template<typename TFunc>
+	double measureCallsPerSecond(TFunc func)
+	{
+		using Clock = std::chrono::steady_clock;
+		constexpr auto minimumDuration = std::chrono::milliseconds(200);
+		static volatile uint64_t s_sink = 0;
+		uint64_t callCount = 0;
+		uint64_t sink = 0;
+		const auto start = Clock::now();
+		auto elapsed = Clock::duration::zero();
+		do
+		{
+			sink += static_cast<uint64_t>(func());
+			++callCount;
+			elapsed = Clock::now() - start;
+		}
+		while(elapsed < minimumDuration);
+		s_sink = s_sink + sink;
+		return static_cast<double>(callCount) / std::chrono::duration<double>(elapsed).count();
+	}
+
+	/// <summary>
+	/// Returns the number of megabytes per second processed by func, where each call processes byteCountPerCall bytes. See measureCallsPerSecond.
+	/// </summary>
+	/// <param name="byteCountPerCall"></param>
+	/// <param name="func"></param>
+	/// <returns></returns>
+	template<typename TFunc>
+	double measureThroughput(size_t byteCountPerCall, TFunc func)
+	{
+		return measureCallsPerSecond(func) * static_cast<double>(byteCountPerCall) / (1024.0 * 1024.0);
+	}
+
+	// the test suites, each in its own file.
+	void runCrc32Tests();
+	void runCrc32Benchmark();
+	void runShaderHashCacheTests();
+	void runShaderHashCacheBenchmark();
+	void runShaderFingerprintTests();
+	void runShaderFingerprintBenchmark();
+	void runGroupConfigurationSnapshotTests();
+	void runGroupConfigurationSnapshotBenchmark();
+	void runAsyncShaderHasherTests();
+	void runFrozenShaderIdSetTests();
+	void runFrozenShaderIdSetBenchmark();
+	void runShaderIdPrefilterTests();
+	void runShaderIdPrefilterBenchmark();
+}
+
+#define CHECK(condition) do { if(!(condition)) { ShaderToggler::reportFailedCheck(#condition, __FILE__, __LINE__); } } while(false)
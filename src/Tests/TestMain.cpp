@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////
+//
+// Part of ShaderToggler, a shader toggler add on for Reshade 5+ which allows you
+// to define groups of shaders to toggle them on/off with one key press
+// 
+// (c) Frans 'Otis_Inf' Bouma.
+//
+// All rights reserved.
+// https://github.com/FransBouma/ShaderToggler
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met :
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+//	  list of conditions and the following disclaimer.
+//
+//  * Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and / or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED.IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+/////////////////////////////////////////////////////////////////////////
+
+#include <cstring>
+
+#include "TestFramework.h"
+
+namespace ShaderToggler
+{
+	static int s_failedCheckCount = 0;
+
+	void reportFailedCheck(const char* condition, const char* file, int line)
+	{
+		++s_failedCheckCount;
+		std::printf("FAILED: %s (%s:%d)\n", condition, file, line);
+	}
+}
+
+
+/// <summary>
+/// Runs all tests and, if --benchmark is passed, the benchmarks. Returns the number of failed checks.
+/// </summary>
+int main(int argc, char* argv[])
+{
+	using namespace ShaderToggler;
+
+	const bool runBenchmarks = argc > 1 && std::strcmp(argv[1], "--benchmark") == 0;
+	struct TestSuite
+	{
+		const char* name;
+		void (*runTests)();
+		void (*runBenchmark)();
+	};
+	const TestSuite testSuites[] =
+	{
+		{ "crc32", &runCrc32Tests, &runCrc32Benchmark },
+		{ "shader hash cache", &runShaderHashCacheTests, &runShaderHashCacheBenchmark },
+		{ "shader fingerprint", &runShaderFingerprintTests, &runShaderFingerprintBenchmark },
+		{ "group configuration snapshot", &runGroupConfigurationSnapshotTests, &runGroupConfigurationSnapshotBenchmark },
+		{ "async shader hasher", &runAsyncShaderHasherTests, nullptr },
+		{ "frozen shader id set", &runFrozenShaderIdSetTests, &runFrozenShaderIdSetBenchmark },
+		{ "shader id prefilter", &runShaderIdPrefilterTests, &runShaderIdPrefilterBenchmark },
+	};
+	for(const auto& testSuite : testSuites)
+	{
+		std::printf("Running %s tests.\n", testSuite.name);
+		testSuite.runTests();
+		if(runBenchmarks && nullptr != testSuite.runBenchmark)
+		{
+			testSuite.runBenchmark();
+		}
+	}
+	std::printf(s_failedCheckCount == 0 ? "All tests passed.\n" : "%d checks failed.\n", s_failedCheckCount);
+	return s_failedCheckCount;
+}
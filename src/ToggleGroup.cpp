@@ -33,9 +33,16 @@
 #include "stdafx.h"
 #include "ToggleGroup.h"
 #include "KeyData.h"
+#include "ShaderIdRegistry.h"
 
 namespace ShaderToggler
 {
+	/// <summary>
+	/// Per ShaderStage the name used in the ini file categories of the stage's hashes, e.g. "Group0_PixelShaders".
+	/// </summary>
+	static constexpr const char* STAGE_INI_NAMES[SHADER_STAGE_COUNT] = { "PixelShaders", "VertexShaders", "ComputeShaders", "HullShaders", "DomainShaders", "GeometryShaders" };
+
+
 	ToggleGroup::ToggleGroup(std::string name, int id): _id(id), _isActive(false), _isEditing(false), _isActiveAtStartup(false)
 	{
 		_name = name.size() > 0 ? name : "Default";
@@ -66,91 +73,114 @@ namespace ShaderToggler
 	}
 
 
-	void ToggleGroup::storeCollectedHashes(const std::unordered_set<uint32_t> pixelShaderHashes, const std::unordered_set<uint32_t> vertexShaderHashes, const std::unordered_set<uint32_t> computeShaderHashes)
+	void ToggleGroup::storeCollectedHashes(ShaderStage stage, const std::unordered_set<uint32_t>& shaderHashes)
 	{
-		clearHashes();
-
-		for(const auto hash : vertexShaderHashes)
-		{
-			_vertexShaderHashes.emplace(hash);
-		}
-		for(const auto hash : pixelShaderHashes)
+		StageShaders& stageShaders = _shadersPerStage[static_cast<size_t>(stage)];
+		stageShaders.hashes.clear();
+		stageShaders.shaderIds.clear();
+		for(const auto hash : shaderHashes)
 		{
-			_pixelShaderHashes.emplace(hash);
-		}
-		for(const auto hash : computeShaderHashes)
-		{
-			_computeShaderHashes.emplace(hash);
+			stageShaders.hashes.emplace(hash);
+			stageShaders.shaderIds.set(ShaderIdRegistry::getShaderId(hash));
 		}
 	}
 
 
-	bool ToggleGroup::isBlockedPixelShader(uint32_t shaderHash)
-	{
-		return _isActive && (_pixelShaderHashes.count(shaderHash)==1);
-	}
-
-
-	bool ToggleGroup::isBlockedVertexShader(uint32_t shaderHash)
+	void ToggleGroup::clearHashes()
 	{
-		return _isActive && (_vertexShaderHashes.count(shaderHash) == 1);
+		for(auto& stageShaders : _shadersPerStage)
+		{
+			stageShaders.hashes.clear();
+			stageShaders.shaderIds.clear();
+		}
 	}
 
 
-	bool ToggleGroup::isBlockedComputeShader(uint32_t shaderHash)
+	void ToggleGroup::setName(std::string newName)
 	{
-		return _isActive && (_computeShaderHashes.count(shaderHash) == 1);
+		if(newName.size()<=0)
+		{
+			return;
+		}
+		_name = newName;
 	}
 
 
-	void ToggleGroup::clearHashes()
+	void ToggleGroup::upgradeFingerprints(ShaderStage stage, const std::unordered_map<uint32_t, uint64_t>& knownFingerprints)
 	{
-		_pixelShaderHashes.clear();
-		_vertexShaderHashes.clear();
-		_computeShaderHashes.clear();
+		StageShaders& stageShaders = _shadersPerStage[static_cast<size_t>(stage)];
+		upgradeFingerprints(stageShaders.hashes, knownFingerprints, stageShaders.fingerprints);
 	}
 
 
-	void ToggleGroup::setName(std::string newName)
+	void ToggleGroup::upgradeFingerprints(const std::unordered_set<uint32_t>& hashes, const std::unordered_map<uint32_t, uint64_t>& knownFingerprints, std::unordered_map<uint32_t, uint64_t>& fingerprints)
 	{
-		if(newName.size()<=0)
+		for(const auto hash : hashes)
 		{
-			return;
+			if(fingerprints.count(hash) == 1)
+			{
+				continue;
+			}
+			const auto it = knownFingerprints.find(hash);
+			if(it != knownFingerprints.end())
+			{
+				fingerprints[hash] = it->second;
+			}
 		}
-		_name = newName;
 	}
 
 
-	void ToggleGroup::saveState(CDataFile& iniFile, int groupCounter) const
+	void ToggleGroup::saveHashes(CDataFile& iniFile, const std::string& category, const std::unordered_set<uint32_t>& hashes, const std::unordered_map<uint32_t, uint64_t>& fingerprints)
 	{
-		const std::string sectionRoot = "Group" + std::to_string(groupCounter);
-		const std::string vertexHashesCategory = sectionRoot + "_VertexShaders";
-		const std::string pixelHashesCategory = sectionRoot + "_PixelShaders";
-		const std::string computeHashesCategory = sectionRoot + "_ComputeShaders";
-
+		// the fingerprint of a hash, if known, is stored with the same counter as the hash, so files without fingerprints stay valid.
 		int counter = 0;
-		for(const auto hash: _vertexShaderHashes)
+		for(const auto hash : hashes)
 		{
-			iniFile.SetUInt("ShaderHash" + std::to_string(counter), hash, "", vertexHashesCategory);
+			iniFile.SetUInt("ShaderHash" + std::to_string(counter), hash, "", category);
+			const auto it = fingerprints.find(hash);
+			if(it != fingerprints.end())
+			{
+				char fingerprintAsString[32];
+				snprintf(fingerprintAsString, sizeof(fingerprintAsString), "%016llX", static_cast<unsigned long long>(it->second));
+				iniFile.SetValue("ShaderFingerprint" + std::to_string(counter), fingerprintAsString, "", category);
+			}
 			counter++;
 		}
-		iniFile.SetUInt("AmountHashes", counter, "", vertexHashesCategory);
+		iniFile.SetUInt("AmountHashes", counter, "", category);
+	}
+
 
-		counter=0;
-		for(const auto hash: _pixelShaderHashes)
+	void ToggleGroup::loadHashes(CDataFile& iniFile, const std::string& category, std::unordered_set<uint32_t>& hashes, std::unordered_map<uint32_t, uint64_t>& fingerprints,
+								 ShaderIdBitset& shaderIds)
+	{
+		const int amountShaders = iniFile.GetInt("AmountHashes", category);
+		for(int i = 0; i < amountShaders; i++)
 		{
-			iniFile.SetUInt("ShaderHash" + std::to_string(counter), hash, "", pixelHashesCategory);
-			counter++;
+			uint32_t hash = iniFile.GetUInt("ShaderHash" + std::to_string(i), category);
+			if(hash == UINT_MAX)
+			{
+				continue;
+			}
+			hashes.emplace(hash);
+			shaderIds.set(ShaderIdRegistry::getShaderId(hash));
+			const std::string fingerprintAsString = iniFile.GetValue("ShaderFingerprint" + std::to_string(i), category);
+			const uint64_t fingerprint = fingerprintAsString.size() > 0 ? strtoull(fingerprintAsString.c_str(), nullptr, 16) : 0;
+			if(fingerprint > 0)
+			{
+				fingerprints[hash] = fingerprint;
+			}
 		}
-		iniFile.SetUInt("AmountHashes", counter, "", pixelHashesCategory);
+	}
+
 
-		counter = 0;
-		for(const auto hash : _computeShaderHashes)
+	void ToggleGroup::saveState(CDataFile& iniFile, int groupCounter) const
+	{
+		const std::string sectionRoot = "Group" + std::to_string(groupCounter);
+		for(size_t stageIndex = 0; stageIndex < SHADER_STAGE_COUNT; ++stageIndex)
 		{
-			iniFile.SetUInt("ShaderHash" + std::to_string(counter), hash, "", computeHashesCategory);
-			counter++;
+			const StageShaders& stageShaders = _shadersPerStage[stageIndex];
+			saveHashes(iniFile, sectionRoot + "_" + STAGE_INI_NAMES[stageIndex], stageShaders.hashes, stageShaders.fingerprints);
 		}
-		iniFile.SetUInt("AmountHashes", counter, "", computeHashesCategory);
 
 		iniFile.SetValue("Name", _name, "", sectionRoot);
 		iniFile.SetUInt("ToggleKey", _keyData.getKeyForIniFile(), "", sectionRoot);
@@ -162,32 +192,12 @@ namespace ShaderToggler
 	{
 		if(groupCounter<0)
 		{
-			int amount = iniFile.GetInt("AmountHashes", "PixelShaders");
-			for(int i = 0;i< amount;i++)
-			{
-				uint32_t hash = iniFile.GetUInt("ShaderHash" + std::to_string(i), "PixelShaders");
-				if(hash!=UINT_MAX)
-				{
-					_pixelShaderHashes.emplace(hash);
-				}
-			}
-			amount = iniFile.GetInt("AmountHashes", "VertexShaders");
-			for(int i = 0;i< amount;i++)
+			// the pre-1.0 format has the categories without a group prefix. Files saved before all stages were tracked lack the categories of
+			// the newer stages, which then simply have no hashes.
+			for(size_t stageIndex = 0; stageIndex < SHADER_STAGE_COUNT; ++stageIndex)
 			{
-				uint32_t hash = iniFile.GetUInt("ShaderHash" + std::to_string(i), "VertexShaders");
-				if(hash!=UINT_MAX)
-				{
-					_vertexShaderHashes.emplace(hash);
-				}
-			}
-			amount = iniFile.GetInt("AmountHashes", "ComputeShaders");
-			for(int i = 0; i < amount; i++)
-			{
-				uint32_t hash = iniFile.GetUInt("ShaderHash" + std::to_string(i), "ComputeShaders");
-				if(hash != UINT_MAX)
-				{
-					_computeShaderHashes.emplace(hash);
-				}
+				StageShaders& stageShaders = _shadersPerStage[stageIndex];
+				loadHashes(iniFile, STAGE_INI_NAMES[stageIndex], stageShaders.hashes, stageShaders.fingerprints, stageShaders.shaderIds);
 			}
 
 			// done
@@ -195,38 +205,10 @@ namespace ShaderToggler
 		}
 
 		const std::string sectionRoot = "Group" + std::to_string(groupCounter);
-		const std::string vertexHashesCategory = sectionRoot + "_VertexShaders";
-		const std::string pixelHashesCategory = sectionRoot + "_PixelShaders";
-		const std::string computeHashesCategory = sectionRoot + "_ComputeShaders";
-
-		int amountShaders = iniFile.GetInt("AmountHashes", vertexHashesCategory);
-		for(int i = 0;i< amountShaders;i++)
-		{
-			uint32_t hash = iniFile.GetUInt("ShaderHash" + std::to_string(i), vertexHashesCategory);
-			if(hash!=UINT_MAX)
-			{
-				_vertexShaderHashes.emplace(hash);
-			}
-		}
-
-		amountShaders = iniFile.GetInt("AmountHashes", pixelHashesCategory);
-		for(int i = 0;i< amountShaders;i++)
+		for(size_t stageIndex = 0; stageIndex < SHADER_STAGE_COUNT; ++stageIndex)
 		{
-			uint32_t hash = iniFile.GetUInt("ShaderHash" + std::to_string(i), pixelHashesCategory);
-			if(hash!=UINT_MAX)
-			{
-				_pixelShaderHashes.emplace(hash);
-			}
-		}
-
-		amountShaders = iniFile.GetInt("AmountHashes", computeHashesCategory);
-		for(int i = 0; i < amountShaders; i++)
-		{
-			uint32_t hash = iniFile.GetUInt("ShaderHash" + std::to_string(i), computeHashesCategory);
-			if(hash != UINT_MAX)
-			{
-				_computeShaderHashes.emplace(hash);
-			}
+			StageShaders& stageShaders = _shadersPerStage[stageIndex];
+			loadHashes(iniFile, sectionRoot + "_" + STAGE_INI_NAMES[stageIndex], stageShaders.hashes, stageShaders.fingerprints, stageShaders.shaderIds);
 		}
 
 		_name = iniFile.GetValue("Name", sectionRoot);
@@ -32,10 +32,13 @@
 #pragma once
 
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 
 #include "CDataFile.h"
 #include "KeyData.h"
+#include "ShaderIdBitset.h"
+#include "ShaderStage.h"
 
 namespace ShaderToggler
 {
@@ -61,10 +64,19 @@ namespace ShaderToggler
 		/// <param name="iniFile"></param>
 		/// <param name="groupCounter">if -1, the ini file is in the pre-1.0 format</param>
 		void loadState(CDataFile& iniFile, int groupCounter);
-		void storeCollectedHashes(const std::unordered_set<uint32_t> pixelShaderHashes, const std::unordered_set<uint32_t> vertexShaderHashes, const std::unordered_set<uint32_t> computeShaderHashes);
-		bool isBlockedPixelShader(uint32_t shaderHash);
-		bool isBlockedVertexShader(uint32_t shaderHash);
-		bool isBlockedComputeShader(uint32_t shaderHash);
+		/// <summary>
+		/// Replaces the shader hashes of the stage specified with the ones passed in.
+		/// </summary>
+		/// <param name="stage"></param>
+		/// <param name="shaderHashes"></param>
+		void storeCollectedHashes(ShaderStage stage, const std::unordered_set<uint32_t>& shaderHashes);
+		/// <summary>
+		/// Stores the 64-bit fingerprints for the shader hashes of the stage specified which don't have a fingerprint yet. Used to upgrade groups which
+		/// were saved with only crc32 hashes: the fingerprints are written next to the existing hashes the next time the group is saved.
+		/// </summary>
+		/// <param name="stage"></param>
+		/// <param name="knownFingerprints">per shader hash of the stage the fingerprint</param>
+		void upgradeFingerprints(ShaderStage stage, const std::unordered_map<uint32_t, uint64_t>& knownFingerprints);
 		void clearHashes();
 
 		void toggleActive() { _isActive = !_isActive;}
@@ -77,11 +89,10 @@ namespace ShaderToggler
 		bool isActiveAtStartup() { return _isActiveAtStartup; }
 		bool isActive() { return _isActive;}
 		bool isEditing() { return _isEditing;}
-		bool isEmpty() const { return _vertexShaderHashes.size() <= 0 && _pixelShaderHashes.size() <= 0 && _computeShaderHashes.size() <= 0; }
 		int getId() const { return _id; }
-		std::unordered_set<uint32_t> getPixelShaderHashes() const { return _pixelShaderHashes;}
-		std::unordered_set<uint32_t> getVertexShaderHashes() const { return _vertexShaderHashes;}
-		std::unordered_set<uint32_t> getComputeShaderHashes() const { return _computeShaderHashes; }
+		std::unordered_set<uint32_t> getShaderHashes(ShaderStage stage) const { return _shadersPerStage[static_cast<size_t>(stage)].hashes; }
+		const std::unordered_map<uint32_t, uint64_t>& getShaderFingerprints(ShaderStage stage) const { return _shadersPerStage[static_cast<size_t>(stage)].fingerprints; }
+		const ShaderIdBitset& getShaderIds(ShaderStage stage) const { return _shadersPerStage[static_cast<size_t>(stage)].shaderIds; }
 		bool isToggleKeyPressed(const reshade::api::effect_runtime* runtime) { return _keyData.isKeyPressed(runtime);}
 		
 		bool operator==(const ToggleGroup& rhs)
@@ -90,12 +101,27 @@ namespace ShaderToggler
 		}
 
 	private:
+		/// <summary>
+		/// The shaders of one stage in the group.
+		/// </summary>
+		struct StageShaders
+		{
+			std::unordered_set<uint32_t> hashes;
+			// the shader ids of the hashes above, for the checks done per draw call.
+			ShaderIdBitset shaderIds;
+			// per shader hash the 64-bit fingerprint of the shader, if known. Kept when hashes are cleared, so they're still there when a hash is re-added.
+			std::unordered_map<uint32_t, uint64_t> fingerprints;
+		};
+
+		static void saveHashes(CDataFile& iniFile, const std::string& category, const std::unordered_set<uint32_t>& hashes, const std::unordered_map<uint32_t, uint64_t>& fingerprints);
+		static void loadHashes(CDataFile& iniFile, const std::string& category, std::unordered_set<uint32_t>& hashes, std::unordered_map<uint32_t, uint64_t>& fingerprints,
+							   ShaderIdBitset& shaderIds);
+		static void upgradeFingerprints(const std::unordered_set<uint32_t>& hashes, const std::unordered_map<uint32_t, uint64_t>& knownFingerprints, std::unordered_map<uint32_t, uint64_t>& fingerprints);
+
 		int _id;
 		std::string	_name;
 		KeyData _keyData;
-		std::unordered_set<uint32_t> _vertexShaderHashes;
-		std::unordered_set<uint32_t> _pixelShaderHashes;
-		std::unordered_set<uint32_t> _computeShaderHashes;
+		StageShaders _shadersPerStage[SHADER_STAGE_COUNT];		// index is the ShaderStage.
 		bool _isActive;				// true means the group is actively toggled (so the hashes have to be hidden).
 		bool _isEditing;			// true means the group is actively edited (name, key)
 		bool _isActiveAtStartup;	// true means the group is active when the host game is started and the toggler has loaded the groups.
@@ -0,0 +1,335 @@
+/*
+ * Copyright (C) 1986 Gary S. Brown.
+ * You may use this program, or code or tables extracted from it, as desired without restriction.
+ *
+ * The folding implementation follows "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction" (Intel, Gopal et al. 2009),
+ * using the bit-reflected constants for the CRC polynomial 0xEDB88320.
+ *
+ * The crc combine implementation follows zlib's crc32_combine (Mark Adler): the crc of the first block is multiplied by x^(8 * size2) modulo the
+ * crc polynomial, which is the same as running it over size2 zero bytes, after which it's xor-ed with the crc of the second block.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+#include <intrin.h>
+#include <thread>
+#include <vector>
+
+#include "crc32_hash.hpp"
+
+// the minimum size of a chunk hashed by a thread in compute_crc32_parallel
+#define CRC32_PARALLEL_MIN_CHUNK_SIZE (256 * 1024)
+// the maximum number of chunks (and therefore threads) used in compute_crc32_parallel
+#define CRC32_PARALLEL_MAX_CHUNK_COUNT 8
+// sizes from which it pays off to hash in parallel, as starting the threads costs tens of microseconds.
+#define CRC32_PARALLEL_THRESHOLD_SLICING16 (1024 * 1024)
+#define CRC32_PARALLEL_THRESHOLD_PCLMUL (8 * 1024 * 1024)
+
+namespace
+{
+	/// <summary>
+	/// The 16 lookup tables used by the slicing-by-16 implementation. Table 0 is the classic byte-wise table.
+	/// Table n contains the crc of a byte followed by n zero bytes.
+	/// </summary>
+	struct Crc32Tables
+	{
+		uint32_t values[16][256];
+
+		Crc32Tables()
+		{
+			for(uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t crc = i;
+				for(int bit = 0; bit < 8; bit++)
+				{
+					crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320 : 0);
+				}
+				values[0][i] = crc;
+			}
+			for(uint32_t i = 0; i < 256; i++)
+			{
+				for(int slice = 1; slice < 16; slice++)
+				{
+					const uint32_t previous = values[slice - 1][i];
+					values[slice][i] = (previous >> 8) ^ values[0][previous & 0xFF];
+				}
+			}
+		}
+	};
+
+
+	const Crc32Tables& getTables()
+	{
+		static const Crc32Tables s_tables;
+		return s_tables;
+	}
+
+
+	uint32_t readUInt32(const uint8_t* data)
+	{
+		uint32_t toReturn;
+		memcpy(&toReturn, data, sizeof(uint32_t));
+		return toReturn;
+	}
+
+
+	/// <summary>
+	/// Multiplies a and b modulo the crc polynomial. Both are bit-reflected polynomials, so x^0 is the highest bit.
+	/// </summary>
+	uint32_t multiplyModP(uint32_t a, uint32_t b)
+	{
+		uint32_t m = 1u << 31;
+		uint32_t p = 0;
+		while(true)
+		{
+			if(a & m)
+			{
+				p ^= b;
+				if((a & (m - 1)) == 0)
+				{
+					break;
+				}
+			}
+			m >>= 1;
+			b = (b & 1) ? (b >> 1) ^ 0xEDB88320 : b >> 1;
+		}
+		return p;
+	}
+
+
+	/// <summary>
+	/// Table with x^(2^n) modulo the crc polynomial, for n is 0...31.
+	/// </summary>
+	struct Crc32PowerTable
+	{
+		uint32_t values[32];
+
+		Crc32PowerTable()
+		{
+			uint32_t p = 1u << 30;		// x^1
+			values[0] = p;
+			for(int n = 1; n < 32; n++)
+			{
+				p = multiplyModP(p, p);
+				values[n] = p;
+			}
+		}
+	};
+
+
+	/// <summary>
+	/// Returns x^(n * 2^k) modulo the crc polynomial.
+	/// </summary>
+	uint32_t x2nModP(size_t n, uint32_t k)
+	{
+		static const Crc32PowerTable s_powerTable;
+		uint32_t p = 1u << 31;		// x^0
+		while(n > 0)
+		{
+			if(n & 1)
+			{
+				p = multiplyModP(s_powerTable.values[k & 31], p);
+			}
+			n >>= 1;
+			k++;
+		}
+		return p;
+	}
+
+
+	typedef uint32_t (*Crc32UpdateFunc)(uint32_t crc, const uint8_t* data, size_t size);
+
+	Crc32UpdateFunc selectImplementation()
+	{
+		return is_crc32_pclmul_supported() ? &update_crc32_pclmul : &update_crc32_slicing16;
+	}
+}
+
+
+uint32_t compute_crc32(const uint8_t *data, size_t size)
+{
+	if(size >= get_crc32_parallel_threshold())
+	{
+		return compute_crc32_parallel(data, size);
+	}
+	return ~update_crc32(0xFFFFFFFF, data, size);
+}
+
+
+uint32_t combine_crc32(uint32_t crc1, uint32_t crc2, size_t size2)
+{
+	// x^(8 * size2): size2 is in bytes, 2^3 bits per byte.
+	return multiplyModP(x2nModP(size2, 3), crc1) ^ crc2;
+}
+
+
+size_t get_crc32_parallel_threshold()
+{
+	static const size_t s_threshold = is_crc32_pclmul_supported() ? CRC32_PARALLEL_THRESHOLD_PCLMUL : CRC32_PARALLEL_THRESHOLD_SLICING16;
+	return s_threshold;
+}
+
+
+uint32_t compute_crc32_parallel(const uint8_t *data, size_t size)
+{
+	const size_t maxChunkCount = std::min<size_t>(CRC32_PARALLEL_MAX_CHUNK_COUNT, std::max(1u, std::thread::hardware_concurrency()));
+	const size_t chunkCount = std::min(maxChunkCount, size / CRC32_PARALLEL_MIN_CHUNK_SIZE);
+	if(chunkCount <= 1)
+	{
+		return ~update_crc32(0xFFFFFFFF, data, size);
+	}
+
+	// The last chunk gets the remainder. All chunks but the first are hashed on other threads, the first one is hashed on the calling thread.
+	const size_t chunkSize = size / chunkCount;
+	std::vector<std::future<uint32_t>> chunkHashes;
+	chunkHashes.reserve(chunkCount - 1);
+	for(size_t i = 1; i < chunkCount; i++)
+	{
+		const uint8_t* chunkStart = data + i * chunkSize;
+		const size_t currentChunkSize = (i == chunkCount - 1) ? size - i * chunkSize : chunkSize;
+		chunkHashes.push_back(std::async(std::launch::async, [chunkStart, currentChunkSize]() { return ~update_crc32(0xFFFFFFFF, chunkStart, currentChunkSize); }));
+	}
+	uint32_t crc = ~update_crc32(0xFFFFFFFF, data, chunkSize);
+	for(size_t i = 1; i < chunkCount; i++)
+	{
+		const size_t currentChunkSize = (i == chunkCount - 1) ? size - i * chunkSize : chunkSize;
+		crc = combine_crc32(crc, chunkHashes[i - 1].get(), currentChunkSize);
+	}
+	return crc;
+}
+
+
+bool is_crc32_pclmul_supported()
+{
+	int cpuInfo[4] = {};
+	__cpuid(cpuInfo, 1);
+	const bool hasPclmul = (cpuInfo[2] & (1 << 1)) != 0;
+	const bool hasSse41 = (cpuInfo[2] & (1 << 19)) != 0;
+	return hasPclmul && hasSse41;
+}
+
+
+uint32_t update_crc32(uint32_t crc, const uint8_t *data, size_t size)
+{
+	// selected once, the first time a hash is calculated.
+	static const Crc32UpdateFunc s_implementation = selectImplementation();
+	return s_implementation(crc, data, size);
+}
+
+
+uint32_t update_crc32_bytewise(uint32_t crc, const uint8_t *data, size_t size)
+{
+	const auto& table = getTables().values[0];
+	for (; size != 0; --size, ++data)
+		crc = (crc >> 8) ^ table[(crc ^ (*data)) & 0xFF];
+	return crc;
+}
+
+
+uint32_t update_crc32_slicing16(uint32_t crc, const uint8_t *data, size_t size)
+{
+	const auto& t = getTables().values;
+	while(size >= 16)
+	{
+		const uint32_t one = readUInt32(data) ^ crc;
+		const uint32_t two = readUInt32(data + 4);
+		const uint32_t three = readUInt32(data + 8);
+		const uint32_t four = readUInt32(data + 12);
+		crc = t[15][one & 0xFF] ^ t[14][(one >> 8) & 0xFF] ^ t[13][(one >> 16) & 0xFF] ^ t[12][one >> 24] ^
+			  t[11][two & 0xFF] ^ t[10][(two >> 8) & 0xFF] ^ t[9][(two >> 16) & 0xFF] ^ t[8][two >> 24] ^
+			  t[7][three & 0xFF] ^ t[6][(three >> 8) & 0xFF] ^ t[5][(three >> 16) & 0xFF] ^ t[4][three >> 24] ^
+			  t[3][four & 0xFF] ^ t[2][(four >> 8) & 0xFF] ^ t[1][(four >> 16) & 0xFF] ^ t[0][four >> 24];
+		data += 16;
+		size -= 16;
+	}
+	return update_crc32_bytewise(crc, data, size);
+}
+
+
+uint32_t update_crc32_pclmul(uint32_t crc, const uint8_t *data, size_t size)
+{
+	if(size < 64)
+	{
+		// not worth setting up the folding for, and the folding needs at least 4 blocks of 16 bytes.
+		return update_crc32_slicing16(crc, data, size);
+	}
+
+	alignas(16) static const uint64_t k1k2[] = { 0x0154442bd4, 0x01c6e41596 };
+	alignas(16) static const uint64_t k3k4[] = { 0x01751997d0, 0x00ccaa009e };
+	alignas(16) static const uint64_t k5k0[] = { 0x0163cd6124, 0x0000000000 };
+	alignas(16) static const uint64_t poly[] = { 0x01db710641, 0x01f7011641 };
+
+	// load the first 64 bytes and fold the current crc register into them
+	__m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00));
+	__m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10));
+	__m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20));
+	__m128i x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30));
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+	__m128i x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k1k2));
+	data += 64;
+	size -= 64;
+
+	// fold 4 blocks of 16 bytes in parallel
+	while(size >= 64)
+	{
+		const __m128i x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		const __m128i x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+		const __m128i x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+		const __m128i x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+		x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+		x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x00)));
+		x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x10)));
+		x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x20)));
+		x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 0x30)));
+		data += 64;
+		size -= 64;
+	}
+
+	// fold the 4 blocks into 1
+	x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(k3k4));
+	__m128i x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+	x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+	x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+	// fold the remaining whole blocks of 16 bytes, if any
+	while(size >= 16)
+	{
+		x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data))), x5);
+		data += 16;
+		size -= 16;
+	}
+
+	// fold 128 bits to 64 bits
+	const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+	x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+	x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+	x0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(k5k0));
+	x2 = _mm_srli_si128(x1, 4);
+	x1 = _mm_and_si128(x1, mask32);
+	x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+
+	// Barrett reduction to 32 bits
+	x0 = _mm_load_si128(reinterpret_cast<const __m128i*>(poly));
+	x2 = _mm_and_si128(x1, mask32);
+	x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+	x2 = _mm_and_si128(x2, mask32);
+	x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+	x1 = _mm_xor_si128(x1, x2);
+	crc = static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+
+	// tail bytes, less than 16
+	return update_crc32_slicing16(crc, data, size);
+}
@@ -0,0 +1,113 @@
+/*
+ * Based on wyhash by Wang Yi, released into the public domain (The Unlicense).
+ */
+
+#include <cstring>
+#include <intrin.h>
+
+#include "fingerprint64_hash.hpp"
+
+namespace
+{
+	const uint64_t SECRET0 = 0xA0761D6478BD642Full;
+	const uint64_t SECRET1 = 0xE7037ED1A0B428DBull;
+	const uint64_t SECRET2 = 0x8EBC6AF09C88C6E3ull;
+	const uint64_t SECRET3 = 0x589965CC75374CC3ull;
+
+	/// <summary>
+	/// Multiplies a and b into a 128-bit value, and returns the low and high 64 bits in a and b.
+	/// </summary>
+	void multiply128(uint64_t& a, uint64_t& b)
+	{
+#if defined(_M_X64)
+		a = _umul128(a, b, &b);
+#else
+		const uint64_t ha = a >> 32, hb = b >> 32, la = static_cast<uint32_t>(a), lb = static_cast<uint32_t>(b);
+		const uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+		const uint64_t t = rl + (rm0 << 32);
+		uint64_t carry = t < rl;
+		const uint64_t lo = t + (rm1 << 32);
+		carry += lo < t;
+		b = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+		a = lo;
+#endif
+	}
+
+
+	uint64_t mix(uint64_t a, uint64_t b)
+	{
+		multiply128(a, b);
+		return a ^ b;
+	}
+
+
+	uint64_t read64(const uint8_t* data)
+	{
+		uint64_t toReturn;
+		memcpy(&toReturn, data, sizeof(uint64_t));
+		return toReturn;
+	}
+
+
+	uint64_t read32(const uint8_t* data)
+	{
+		uint32_t toReturn;
+		memcpy(&toReturn, data, sizeof(uint32_t));
+		return toReturn;
+	}
+}
+
+
+uint64_t compute_fingerprint64(const uint8_t *data, size_t size)
+{
+	uint64_t seed = mix(static_cast<uint64_t>(size) ^ SECRET0, SECRET1);
+	uint64_t a = 0;
+	uint64_t b = 0;
+	if(size <= 16)
+	{
+		if(size >= 4)
+		{
+			const size_t offset = (size >> 3) << 2;
+			a = (read32(data) << 32) | read32(data + offset);
+			b = (read32(data + size - 4) << 32) | read32(data + size - 4 - offset);
+		}
+		else if(size > 0)
+		{
+			a = (static_cast<uint64_t>(data[0]) << 16) | (static_cast<uint64_t>(data[size >> 1]) << 8) | data[size - 1];
+		}
+	}
+	else
+	{
+		const uint8_t* current = data;
+		size_t remaining = size;
+		if(remaining > 48)
+		{
+			// 3 independent lanes, so the multiplications can overlap.
+			uint64_t seed1 = seed;
+			uint64_t seed2 = seed;
+			do
+			{
+				seed = mix(read64(current) ^ SECRET1, read64(current + 8) ^ seed);
+				seed1 = mix(read64(current + 16) ^ SECRET2, read64(current + 24) ^ seed1);
+				seed2 = mix(read64(current + 32) ^ SECRET3, read64(current + 40) ^ seed2);
+				current += 48;
+				remaining -= 48;
+			}
+			while(remaining > 48);
+			seed ^= seed1 ^ seed2;
+		}
+		while(remaining > 16)
+		{
+			seed = mix(read64(current) ^ SECRET1, read64(current + 8) ^ seed);
+			current += 16;
+			remaining -= 16;
+		}
+		// the last 16 bytes, which can overlap with bytes already processed.
+		a = read64(current + remaining - 16);
+		b = read64(current + remaining - 8);
+	}
+	a ^= SECRET1;
+	b ^= seed;
+	multiply128(a, b);
+	return mix(a ^ SECRET0 ^ static_cast<uint64_t>(size), b ^ SECRET1);
+}
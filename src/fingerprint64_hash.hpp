@@ -0,0 +1,17 @@
+/*
+ * Based on wyhash by Wang Yi, released into the public domain (The Unlicense).
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// <summary>
+/// Calculates a fast 64-bit fingerprint of the passed in data. Used next to the crc32 of a shader to detect different shaders which have the
+/// same crc32. The values aren't compatible with the reference wyhash implementation and should only be compared with values calculated by this function.
+/// </summary>
+/// <param name="data"></param>
+/// <param name="size"></param>
+/// <returns></returns>
+uint64_t compute_fingerprint64(const uint8_t *data, size_t size);